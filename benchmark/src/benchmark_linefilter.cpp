@@ -0,0 +1,63 @@
+#include <array>
+#include <cmath>
+#include <cstdlib>
+
+#include <LineFilter.hpp>
+
+#include <micro/math/numeric.hpp>
+
+#include <benchmark/benchmark.h>
+
+using namespace micro;
+
+namespace {
+
+constexpr size_t NUM_FRAMES = 64;
+
+// Lines 40mm apart, drifting slowly together, with a random noise of the detections.
+// Every 16th frame misses a line, so the unmatched lines are handled as well.
+std::array<LinePositions, NUM_FRAMES> createFrames(const size_t numLines) {
+    std::array<LinePositions, NUM_FRAMES> frames;
+
+    for (size_t f = 0; f < NUM_FRAMES; ++f) {
+        const millimeter_t drift = millimeter_t(10 * std::sin(2 * M_PI * f / NUM_FRAMES));
+        for (size_t i = 0; i < numLines; ++i) {
+            if (f % 16 == 15 && i == f / 16 % numLines) {
+                continue;
+            }
+            const millimeter_t noise = millimeter_t(static_cast<float>(rand() % 600) / 100 - 3);
+            frames[f].insert({millimeter_t(-100) + i * millimeter_t(40) + drift + noise, 1.0f});
+        }
+    }
+
+    return frames;
+}
+
+} // namespace
+
+template <size_t MAX_LINES, typename line_state_t>
+static void BM_LineFilter(benchmark::State& state) {
+    const auto frames = createFrames(state.range(0));
+    BasicLineFilter<MAX_LINES, line_state_t> lineFilter;
+    Lines lines;
+    size_t i = 0;
+
+    for (auto _ : state) {
+        lineFilter.update(frames[i++ % NUM_FRAMES], Line::MAX_NUM_LINES, lines);
+        benchmark::DoNotOptimize(lines);
+    }
+
+    state.counters["state_bytes"]  = sizeof(line_state_t);
+    state.counters["filter_bytes"] = sizeof(lineFilter);
+}
+
+constexpr size_t MAX_LINES = cfg::MAX_NUM_FILTERED_LINES;
+
+BENCHMARK_TEMPLATE(BM_LineFilter, MAX_LINES, SampleHistoryLineState)
+    ->DenseRange(1, Line::MAX_NUM_LINES);
+BENCHMARK_TEMPLATE(BM_LineFilter, MAX_LINES, AlphaBetaLineState)
+    ->DenseRange(1, Line::MAX_NUM_LINES);
+BENCHMARK_TEMPLATE(BM_LineFilter, MAX_LINES, KalmanLineState)->DenseRange(1, Line::MAX_NUM_LINES);
+BENCHMARK_TEMPLATE(BM_LineFilter, 3, SampleHistoryLineState)->DenseRange(1, 3);
+BENCHMARK_TEMPLATE(BM_LineFilter, 3, AlphaBetaLineState)->DenseRange(1, 3);
+BENCHMARK_TEMPLATE(BM_LineFilter, 3, KalmanLineState)->DenseRange(1, 3);
@@ -3,8 +3,10 @@
 
 #include <LineFilter.hpp>
 #include <LinePatternCalculator.hpp>
+#include <LinePipeline.hpp>
 #include <LinePosCalculator.hpp>
 #include <random>
+#include <vector>
 
 #include <micro/container/vector.hpp>
 #include <micro/math/numeric.hpp>
@@ -17,19 +19,20 @@ using namespace micro;
 namespace {
 
 // Helper function to create realistic sensor measurements
+template <typename calculator_t = LinePosCalculator>
 void createMeasurements(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>& lines,
-                        Measurements& meas) {
+                        typename calculator_t::Measurements& meas) {
     static const double RANDOM_WEIGHT = 0.25;
     static const double SIGMA         = 1.0;
     static const double MAX_Z_SCORE   = 1.0 / (SIGMA * std::sqrt(2 * M_PI));
 
-    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+    for (uint8_t i = 0; i < calculator_t::NUM_SENSORS; ++i) {
         meas[i] = 0;
     }
 
-    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+    for (uint8_t i = 0; i < calculator_t::NUM_SENSORS; ++i) {
         for (millimeter_t linePos : lines) {
-            const double z_score = (i - LinePosCalculator::linePosToOptoPos(linePos)) / SIGMA;
+            const double z_score = (i - calculator_t::linePosToOptoPos(linePos)) / SIGMA;
             const double value =
                 1.0 / (SIGMA * std::sqrt(2 * M_PI)) * exp(-0.5 * z_score * z_score);
 
@@ -52,6 +55,20 @@ void createMeasurements(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>&
     }
 }
 
+// Creates frames alternating between the measurements and the measurements shifted by a constant.
+// Every sensor changes between consecutive frames, so the whole scan range is recalculated.
+template <typename calculator_t = LinePosCalculator>
+std::array<typename calculator_t::Measurements, 2>
+createAlternatingFrames(const typename calculator_t::Measurements& measurements) {
+    static constexpr uint8_t SHIFT = 2 * cfg::LINE_POS_CALC_MEASUREMENT_DEADBAND + 4;
+
+    std::array<typename calculator_t::Measurements, 2> frames = {measurements, measurements};
+    for (uint8_t i = 0; i < calculator_t::NUM_SENSORS; ++i) {
+        frames[1][i] = measurements[i] < 128 ? measurements[i] + SHIFT : measurements[i] - SHIFT;
+    }
+    return frames;
+}
+
 } // namespace
 
 // Benchmark full line calculation pipeline as used in LineCalcTask
@@ -89,3 +106,319 @@ static void BM_LineCalculationPipeline(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_LineCalculationPipeline);
+
+// Benchmark line position calculation with float and Q15 fixed-point arithmetic
+template <typename intensity_t>
+static void BM_LinePosCalculator(benchmark::State& state) {
+    BasicLinePosCalculator<intensity_t> linePosCalc(false); // with calibration disabled
+
+    Measurements measurements;
+    micro::vector<millimeter_t, Line::MAX_NUM_LINES> testLines = {millimeter_t(-80),
+                                                                  millimeter_t(70)};
+    createMeasurements(testLines, measurements);
+
+    const std::array<Measurements, 2> frames = createAlternatingFrames(measurements);
+    size_t frameIdx                          = 0;
+
+    for (auto _ : state) {
+        auto linePositions = linePosCalc.calculate(frames[frameIdx++ % 2], Line::MAX_NUM_LINES);
+        benchmark::DoNotOptimize(linePositions);
+    }
+}
+BENCHMARK_TEMPLATE(BM_LinePosCalculator, float);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator, q15_t);
+
+// Benchmark line position calculation of sensor arrays of different sizes
+template <typename intensity_t, typename sensor_array_t>
+static void BM_LinePosCalculator_SensorArray(benchmark::State& state) {
+    using calculator_t = BasicLinePosCalculator<intensity_t, sensor_array_t>;
+    calculator_t linePosCalc(false); // with calibration disabled
+
+    typename calculator_t::Measurements measurements;
+    micro::vector<millimeter_t, Line::MAX_NUM_LINES> testLines = {millimeter_t(-60),
+                                                                  millimeter_t(50)};
+    createMeasurements<calculator_t>(testLines, measurements);
+
+    const auto frames = createAlternatingFrames<calculator_t>(measurements);
+    size_t frameIdx   = 0;
+
+    for (auto _ : state) {
+        auto linePositions = linePosCalc.calculate(frames[frameIdx++ % 2], Line::MAX_NUM_LINES);
+        benchmark::DoNotOptimize(linePositions);
+    }
+}
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_SensorArray, float, SensorArray32);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_SensorArray, float, PanelSensorArray);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_SensorArray, float, SensorArray64);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_SensorArray, q15_t, SensorArray32);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_SensorArray, q15_t, PanelSensorArray);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_SensorArray, q15_t, SensorArray64);
+
+// Benchmark line position calculation of a noisy frame without lines,
+// where all sensor groups are candidates for the line selection
+template <typename intensity_t>
+static void BM_LinePosCalculator_Noise(benchmark::State& state) {
+    BasicLinePosCalculator<intensity_t> linePosCalc(false); // with calibration disabled
+
+    Measurements measurements;
+    std::mt19937 rng(0);
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        measurements[i] = rng() % 64;
+    }
+
+    const std::array<Measurements, 2> frames = createAlternatingFrames(measurements);
+    size_t frameIdx                          = 0;
+
+    for (auto _ : state) {
+        auto linePositions = linePosCalc.calculate(frames[frameIdx++ % 2], Line::MAX_NUM_LINES);
+        benchmark::DoNotOptimize(linePositions);
+    }
+}
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_Noise, float);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_Noise, q15_t);
+
+// Benchmark line position calculation of a frame without lines, measuring only slightly above the
+// white levels. The frame is classified as NoLine, and the line search is skipped.
+template <typename intensity_t>
+static void BM_LinePosCalculator_NoLine(benchmark::State& state) {
+    BasicLinePosCalculator<intensity_t> linePosCalc(false); // with calibration disabled
+
+    Measurements measurements;
+    std::mt19937 rng(0);
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        measurements[i] = rng() % 32;
+    }
+
+    const std::array<Measurements, 2> frames = createAlternatingFrames(measurements);
+    size_t frameIdx                          = 0;
+
+    for (auto _ : state) {
+        auto linePositions = linePosCalc.calculate(frames[frameIdx++ % 2], Line::MAX_NUM_LINES);
+        benchmark::DoNotOptimize(linePositions);
+    }
+}
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_NoLine, float);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_NoLine, q15_t);
+
+// Benchmark line position calculation of two lines, with only the sensors around the first line
+// being scanned
+template <typename intensity_t>
+static void BM_LinePosCalculator_ScanRange(benchmark::State& state) {
+    BasicLinePosCalculator<intensity_t> linePosCalc(false); // with calibration disabled
+
+    Measurements measurements;
+    micro::vector<millimeter_t, Line::MAX_NUM_LINES> testLines = {millimeter_t(-80),
+                                                                  millimeter_t(70)};
+    createMeasurements(testLines, measurements);
+
+    SensorControlData sensorControl;
+    sensorControl.scanRangeCenter =
+        static_cast<uint8_t>(std::lround(LinePosCalculator::linePosToOptoPos(testLines[0])));
+    sensorControl.scanRangeRadius = 8;
+    const ScanRange scanRange     = sensorControl.scanRange();
+
+    const std::array<Measurements, 2> frames = createAlternatingFrames(measurements);
+    size_t frameIdx                          = 0;
+
+    for (auto _ : state) {
+        auto linePositions =
+            linePosCalc.calculate(frames[frameIdx++ % 2], Line::MAX_NUM_LINES, scanRange);
+        benchmark::DoNotOptimize(linePositions);
+    }
+}
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_ScanRange, float);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_ScanRange, q15_t);
+
+// Benchmark line position calculation of slowly changing frames, where only a few sensors change
+// between consecutive frames, and only their neighbourhoods are recalculated
+template <typename intensity_t>
+static void BM_LinePosCalculator_SlowChanges(benchmark::State& state) {
+    static constexpr size_t NUM_FRAMES = 64;
+
+    BasicLinePosCalculator<intensity_t> linePosCalc(false); // with calibration disabled
+
+    std::vector<Measurements> frames(NUM_FRAMES);
+    createMeasurements({millimeter_t(-80), millimeter_t(70)}, frames[0]);
+
+    std::mt19937 rng(0);
+    for (size_t i = 1; i < NUM_FRAMES; ++i) {
+        frames[i] = frames[i - 1];
+        for (uint8_t j = 0; j < 2; ++j) {
+            Measurements::value_type& meas = frames[i][rng() % cfg::NUM_SENSORS];
+            meas = meas < 128 ? meas + 10 : meas - 10;
+        }
+    }
+
+    size_t frameIdx = 0;
+    for (auto _ : state) {
+        auto linePositions =
+            linePosCalc.calculate(frames[frameIdx++ % NUM_FRAMES], Line::MAX_NUM_LINES);
+        benchmark::DoNotOptimize(linePositions);
+    }
+}
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_SlowChanges, float);
+BENCHMARK_TEMPLATE(BM_LinePosCalculator_SlowChanges, q15_t);
+
+// Benchmark line position calculation of a line at random sub-sensor positions with each line
+// position estimator, the mean absolute position error is reported as a counter
+template <typename intensity_t, linePosEstimator_t ESTIMATOR>
+static void BM_LinePosEstimator(benchmark::State& state) {
+    static constexpr size_t NUM_FRAMES = 256;
+
+    BasicLinePosCalculator<intensity_t> linePosCalc(false, false, ESTIMATOR);
+
+    std::vector<millimeter_t> linePositions(NUM_FRAMES);
+    std::vector<Measurements> frames(NUM_FRAMES);
+    for (size_t i = 0; i < NUM_FRAMES; ++i) {
+        linePositions[i] = millimeter_t(-100 + (rand() % 20000) / 100.0f);
+        createMeasurements({linePositions[i]}, frames[i]);
+    }
+
+    size_t frameIdx = 0;
+    double error    = 0.0;
+    size_t numLines = 0;
+    for (auto _ : state) {
+        const size_t i = frameIdx++ % NUM_FRAMES;
+        auto positions = linePosCalc.calculate(frames[i], Line::MAX_NUM_LINES);
+        benchmark::DoNotOptimize(positions);
+
+        if (positions.size() == 1) {
+            error += abs(positions.begin()->pos - linePositions[i]).get();
+            ++numLines;
+        }
+    }
+    state.counters["error_mm"] = numLines > 0 ? error / numLines : 0.0;
+}
+BENCHMARK_TEMPLATE(BM_LinePosEstimator, float, linePosEstimator_t::Centroid);
+BENCHMARK_TEMPLATE(BM_LinePosEstimator, float, linePosEstimator_t::Parabola);
+BENCHMARK_TEMPLATE(BM_LinePosEstimator, float, linePosEstimator_t::Gaussian);
+BENCHMARK_TEMPLATE(BM_LinePosEstimator, q15_t, linePosEstimator_t::Centroid);
+BENCHMARK_TEMPLATE(BM_LinePosEstimator, q15_t, linePosEstimator_t::Parabola);
+BENCHMARK_TEMPLATE(BM_LinePosEstimator, q15_t, linePosEstimator_t::Gaussian);
+
+// Benchmark line position calculation of a line at random sub-sensor positions with each line
+// detector, the mean absolute position error is reported as a counter
+template <typename intensity_t, lineDetector_t DETECTOR>
+static void BM_LineDetector(benchmark::State& state) {
+    static constexpr size_t NUM_FRAMES = 256;
+
+    BasicLinePosCalculator<intensity_t> linePosCalc(false);
+    linePosCalc.setLineDetector(DETECTOR);
+
+    std::vector<millimeter_t> linePositions(NUM_FRAMES);
+    std::vector<Measurements> frames(NUM_FRAMES);
+    for (size_t i = 0; i < NUM_FRAMES; ++i) {
+        linePositions[i] = millimeter_t(-100 + (rand() % 20000) / 100.0f);
+        createMeasurements({linePositions[i]}, frames[i]);
+    }
+
+    size_t frameIdx = 0;
+    double error    = 0.0;
+    size_t numLines = 0;
+    for (auto _ : state) {
+        const size_t i = frameIdx++ % NUM_FRAMES;
+        auto positions = linePosCalc.calculate(frames[i], Line::MAX_NUM_LINES);
+        benchmark::DoNotOptimize(positions);
+
+        if (positions.size() == 1) {
+            error += abs(positions.begin()->pos - linePositions[i]).get();
+            ++numLines;
+        }
+    }
+    state.counters["error_mm"] = numLines > 0 ? error / numLines : 0.0;
+}
+BENCHMARK_TEMPLATE(BM_LineDetector, float, lineDetector_t::GroupIntensity);
+BENCHMARK_TEMPLATE(BM_LineDetector, float, lineDetector_t::MatchedFilter);
+BENCHMARK_TEMPLATE(BM_LineDetector, q15_t, lineDetector_t::GroupIntensity);
+BENCHMARK_TEMPLATE(BM_LineDetector, q15_t, lineDetector_t::MatchedFilter);
+
+// Benchmark line position calculation with each line search mode,
+// the number of lines is given as the argument
+template <typename intensity_t, lineSearch_t SEARCH>
+static void BM_LineSearch(benchmark::State& state) {
+    BasicLinePosCalculator<intensity_t> linePosCalc(false, false, linePosEstimator_t::Centroid,
+                                                    SEARCH);
+
+    const micro::vector<millimeter_t, Line::MAX_NUM_LINES> lines[] = {
+        {millimeter_t(-20)},
+        {millimeter_t(-80), millimeter_t(70)},
+        {millimeter_t(-120), millimeter_t(0), millimeter_t(110)}};
+
+    Measurements measurements;
+    createMeasurements(lines[state.range(0) - 1], measurements);
+
+    const std::array<Measurements, 2> frames = createAlternatingFrames(measurements);
+    size_t frameIdx                          = 0;
+
+    for (auto _ : state) {
+        auto linePositions = linePosCalc.calculate(frames[frameIdx++ % 2], Line::MAX_NUM_LINES);
+        benchmark::DoNotOptimize(linePositions);
+    }
+}
+BENCHMARK_TEMPLATE(BM_LineSearch, float, lineSearch_t::Full)->DenseRange(1, 3);
+BENCHMARK_TEMPLATE(BM_LineSearch, float, lineSearch_t::CoarseToFine)->DenseRange(1, 3);
+BENCHMARK_TEMPLATE(BM_LineSearch, q15_t, lineSearch_t::Full)->DenseRange(1, 3);
+BENCHMARK_TEMPLATE(BM_LineSearch, q15_t, lineSearch_t::CoarseToFine)->DenseRange(1, 3);
+
+namespace {
+
+constexpr size_t NUM_RECORDED_FRAMES = 1000;
+
+struct RecordedFrames {
+    std::vector<Measurements> measurements;
+    std::vector<meter_t> distances;
+    std::vector<m_per_sec_t> speeds;
+
+    RecordedFrames()
+        : measurements(NUM_RECORDED_FRAMES), distances(NUM_RECORDED_FRAMES),
+          speeds(NUM_RECORDED_FRAMES) {
+        for (size_t i = 0; i < NUM_RECORDED_FRAMES; ++i) {
+            createMeasurements({millimeter_t(100 * std::sin(i / 100.0))}, measurements[i]);
+            distances[i] = meter_t(i * 0.01f);
+            speeds[i]    = m_per_sec_t(1.0f);
+        }
+    }
+};
+
+} // namespace
+
+// Benchmark replaying recorded frames through the pipeline one frame at a time
+static void BM_LinePipeline_SingleFrames(benchmark::State& state) {
+    const RecordedFrames frames;
+
+    for (auto _ : state) {
+        LinePosCalculator linePosCalc(false);
+        LineFilter lineFilter;
+        LinePatternCalculator linePatternCalc;
+
+        for (size_t i = 0; i < NUM_RECORDED_FRAMES; ++i) {
+            auto linePositions = linePosCalc.calculate(frames.measurements[i], 1);
+            auto lines         = lineFilter.update(linePositions, 1);
+            linePatternCalc.update(linePatternDomain_t::Race, lines, frames.distances[i],
+                                   sgn(frames.speeds[i]));
+            auto pattern = linePatternCalc.pattern();
+            benchmark::DoNotOptimize(lines);
+            benchmark::DoNotOptimize(pattern);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_RECORDED_FRAMES);
+}
+BENCHMARK(BM_LinePipeline_SingleFrames);
+
+// Benchmark replaying recorded frames through the pipeline in one batch
+static void BM_LinePipeline_Batch(benchmark::State& state) {
+    const RecordedFrames frames;
+    std::vector<Lines> lines(NUM_RECORDED_FRAMES);
+    std::vector<LinePattern> patterns(NUM_RECORDED_FRAMES);
+
+    for (auto _ : state) {
+        LinePipeline pipeline(false);
+        pipeline.run(linePatternDomain_t::Race, 1, frames.measurements.data(),
+                     frames.distances.data(), frames.speeds.data(), NUM_RECORDED_FRAMES,
+                     lines.data(), patterns.data());
+        benchmark::DoNotOptimize(lines.data());
+        benchmark::DoNotOptimize(patterns.data());
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_RECORDED_FRAMES);
+}
+BENCHMARK(BM_LinePipeline_Batch);
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+#include <LinePosCalculator.hpp>
+#include <SensorKernels.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+template <typename T>
+struct KernelInputs {
+    Measurements measurements;
+    Measurements whiteLevels;
+    typename IntensityTraits<T>::gain_t gains[cfg::NUM_SENSORS];
+    T values[cfg::NUM_SENSORS];
+    T offsets[cfg::NUM_SENSORS];
+    T result[cfg::NUM_SENSORS];
+
+    KernelInputs() {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            measurements[i] = rand() % 256;
+            whiteLevels[i]  = rand() % 100;
+            gains[i]        = IntensityTraits<T>::gain(whiteLevels[i]);
+            values[i]       = IntensityTraits<T>::fromFloat((rand() % 1000) / 1000.0f);
+            offsets[i]      = IntensityTraits<T>::fromFloat((rand() % 300) / 1000.0f);
+        }
+    }
+};
+
+} // namespace
+
+// Benchmark white level scaling stage with scalar arithmetic, dividing by the range of each sensor
+template <typename T>
+static void BM_Scale_Scalar(benchmark::State& state) {
+    KernelInputs<T> in;
+    for (auto _ : state) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            in.result[i] = IntensityTraits<T>::scale(in.measurements[i], in.whiteLevels[i]);
+        }
+        benchmark::DoNotOptimize(in.result);
+    }
+}
+BENCHMARK_TEMPLATE(BM_Scale_Scalar, float);
+BENCHMARK_TEMPLATE(BM_Scale_Scalar, q15_t);
+
+// Benchmark white level scaling stage with the array kernel, using the precomputed gains
+template <typename T>
+static void BM_Scale_Kernel(benchmark::State& state) {
+    KernelInputs<T> in;
+    for (auto _ : state) {
+        kernel::scale(in.measurements.data(), in.whiteLevels.data(), in.gains, in.result,
+                      cfg::NUM_SENSORS);
+        benchmark::DoNotOptimize(in.result);
+    }
+}
+BENCHMARK_TEMPLATE(BM_Scale_Kernel, float);
+BENCHMARK_TEMPLATE(BM_Scale_Kernel, q15_t);
+
+// Benchmark offset removal stage with scalar arithmetic
+template <typename T>
+static void BM_RemoveOffset_Scalar(benchmark::State& state) {
+    KernelInputs<T> in;
+    for (auto _ : state) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            in.result[i] = IntensityTraits<T>::removeOffset(in.values[i], in.offsets[i]);
+        }
+        benchmark::DoNotOptimize(in.result);
+    }
+}
+BENCHMARK_TEMPLATE(BM_RemoveOffset_Scalar, float);
+BENCHMARK_TEMPLATE(BM_RemoveOffset_Scalar, q15_t);
+
+// Benchmark offset removal stage with the array kernel
+template <typename T>
+static void BM_RemoveOffset_Kernel(benchmark::State& state) {
+    KernelInputs<T> in;
+    for (auto _ : state) {
+        kernel::removeOffset(in.values, in.offsets, in.result, cfg::NUM_SENSORS);
+        benchmark::DoNotOptimize(in.result);
+    }
+}
+BENCHMARK_TEMPLATE(BM_RemoveOffset_Kernel, float);
+BENCHMARK_TEMPLATE(BM_RemoveOffset_Kernel, q15_t);
+
+// Benchmark group intensity weighting stage with scalar arithmetic
+template <typename T>
+static void BM_WeightedAverage_Scalar(benchmark::State& state) {
+    static constexpr WeightCalculator CALC(cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS);
+    using traits = IntensityTraits<T>;
+
+    KernelInputs<T> in;
+    for (auto _ : state) {
+        for (uint8_t i = CALC.radius; i < cfg::NUM_SENSORS - CALC.radius; ++i) {
+            typename traits::accumulator_t sum = 0;
+            for (int8_t subIdx = -CALC.radius; subIdx <= CALC.radius; ++subIdx) {
+                sum += traits::weight(CALC.weight(subIdx)) * in.values[i + subIdx];
+            }
+            in.result[i] = static_cast<T>(sum / traits::weight(CALC.sumWeight));
+        }
+        benchmark::DoNotOptimize(in.result);
+    }
+}
+BENCHMARK_TEMPLATE(BM_WeightedAverage_Scalar, float);
+BENCHMARK_TEMPLATE(BM_WeightedAverage_Scalar, q15_t);
+
+// Benchmark group intensity weighting stage with the array kernel
+template <typename T>
+static void BM_WeightedAverage_Kernel(benchmark::State& state) {
+    static constexpr WeightCalculator CALC(cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS);
+    using traits = IntensityTraits<T>;
+
+    typename traits::accumulator_t weights[2 * CALC.radius + 1];
+    for (int8_t subIdx = -CALC.radius; subIdx <= CALC.radius; ++subIdx) {
+        weights[subIdx + CALC.radius] = traits::averageWeight(CALC.weight(subIdx), CALC.sumWeight);
+    }
+    KernelInputs<T> in;
+    for (auto _ : state) {
+        kernel::weightedAverage<CALC.radius>(in.values, weights, in.result, cfg::NUM_SENSORS);
+        benchmark::DoNotOptimize(in.result);
+    }
+}
+BENCHMARK_TEMPLATE(BM_WeightedAverage_Kernel, float);
+BENCHMARK_TEMPLATE(BM_WeightedAverage_Kernel, q15_t);
+
+// Benchmark line position calculation of each peak with a runtime weight calculator,
+// the radius is clamped to the sensors left of the center
+template <typename T>
+static void BM_CenterOffset_Scalar(benchmark::State& state) {
+    using traits = IntensityTraits<T>;
+
+    KernelInputs<T> in;
+    float offsets[cfg::NUM_SENSORS];
+    for (auto _ : state) {
+        for (uint8_t centerIdx = 1; centerIdx < cfg::NUM_SENSORS - 1; ++centerIdx) {
+            const WeightCalculator calc(
+                std::min(cfg::LINE_POS_CALC_GROUP_RADIUS, static_cast<float>(centerIdx)));
+
+            typename traits::accumulator_t sum  = 0;
+            typename traits::accumulator_t sumW = 0;
+            for (int8_t subIdx = -calc.radius; subIdx <= calc.radius; ++subIdx) {
+                const typename traits::accumulator_t mw =
+                    traits::weight(calc.weight(subIdx)) * in.values[centerIdx + subIdx];
+                sum += mw;
+                sumW += mw * subIdx;
+            }
+            offsets[centerIdx] = static_cast<float>(sumW) / static_cast<float>(sum);
+        }
+        benchmark::DoNotOptimize(offsets);
+    }
+    state.SetItemsProcessed(state.iterations() * (cfg::NUM_SENSORS - 2));
+}
+BENCHMARK_TEMPLATE(BM_CenterOffset_Scalar, float);
+BENCHMARK_TEMPLATE(BM_CenterOffset_Scalar, q15_t);
+
+// Benchmark line position calculation of each peak with the unrolled kernel and constant weights
+template <typename T>
+static void BM_CenterOffset_Kernel(benchmark::State& state) {
+    static constexpr WeightCalculator CALC(cfg::LINE_POS_CALC_GROUP_RADIUS);
+    using traits = IntensityTraits<T>;
+
+    static constexpr auto WEIGHTS = [] {
+        std::array<typename traits::accumulator_t, 2 * CALC.radius + 1> weights{};
+        for (int8_t subIdx = -CALC.radius; subIdx <= CALC.radius; ++subIdx) {
+            weights[subIdx + CALC.radius] = traits::weight(CALC.weight(subIdx));
+        }
+        return weights;
+    }();
+
+    KernelInputs<T> in;
+    float offsets[cfg::NUM_SENSORS];
+    for (auto _ : state) {
+        for (uint8_t centerIdx = CALC.radius; centerIdx < cfg::NUM_SENSORS - CALC.radius;
+             ++centerIdx) {
+            offsets[centerIdx] = kernel::centerOffset<CALC.radius>(
+                &in.values[centerIdx - CALC.radius], WEIGHTS.data());
+        }
+        benchmark::DoNotOptimize(offsets);
+    }
+    state.SetItemsProcessed(state.iterations() * (cfg::NUM_SENSORS - 2 * CALC.radius));
+}
+BENCHMARK_TEMPLATE(BM_CenterOffset_Kernel, float);
+BENCHMARK_TEMPLATE(BM_CenterOffset_Kernel, q15_t);
+
+// Benchmark line position calculation of each peak with the parabola fit
+template <typename T>
+static void BM_ParabolaOffset(benchmark::State& state) {
+    KernelInputs<T> in;
+    float offsets[cfg::NUM_SENSORS];
+    for (auto _ : state) {
+        for (uint8_t centerIdx = 1; centerIdx < cfg::NUM_SENSORS - 1; ++centerIdx) {
+            kernel::parabolaOffset(&in.values[centerIdx - 1], offsets[centerIdx]);
+        }
+        benchmark::DoNotOptimize(offsets);
+    }
+    state.SetItemsProcessed(state.iterations() * (cfg::NUM_SENSORS - 2));
+}
+BENCHMARK_TEMPLATE(BM_ParabolaOffset, float);
+BENCHMARK_TEMPLATE(BM_ParabolaOffset, q15_t);
+
+// Benchmark line position calculation of each peak with the Gaussian fit
+template <typename T>
+static void BM_GaussianOffset(benchmark::State& state) {
+    KernelInputs<T> in;
+    float offsets[cfg::NUM_SENSORS];
+    for (auto _ : state) {
+        for (uint8_t centerIdx = 1; centerIdx < cfg::NUM_SENSORS - 1; ++centerIdx) {
+            kernel::gaussianOffset(&in.values[centerIdx - 1], offsets[centerIdx]);
+        }
+        benchmark::DoNotOptimize(offsets);
+    }
+    state.SetItemsProcessed(state.iterations() * (cfg::NUM_SENSORS - 2));
+}
+BENCHMARK_TEMPLATE(BM_GaussianOffset, float);
+BENCHMARK_TEMPLATE(BM_GaussianOffset, q15_t);
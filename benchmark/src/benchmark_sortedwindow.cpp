@@ -0,0 +1,59 @@
+#include <cstdlib>
+
+#include <IntensityTraits.hpp>
+#include <SortedWindow.hpp>
+#include <cfg_sensor.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr uint8_t RADIUS = cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS;
+constexpr uint8_t RANK   = (2 * RADIUS + 1) / 3;
+
+template <typename T>
+void createIntensities(T* const values) {
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        values[i] = IntensityTraits<T>::fromFloat((rand() % 1000) / 1000.0f);
+    }
+}
+
+} // namespace
+
+// Benchmark offset filter stage with a full sort of the window of each sensor
+template <typename T>
+static void BM_OffsetFilter_Sort(benchmark::State& state) {
+    T values[cfg::NUM_SENSORS];
+    T result[cfg::NUM_SENSORS];
+    createIntensities(values);
+
+    for (auto _ : state) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            const uint8_t startIdx = std::max<uint8_t>(i, RADIUS) - RADIUS;
+            const uint8_t endIdx   = std::min<uint8_t>(i + RADIUS + 1, cfg::NUM_SENSORS);
+
+            std::array<T, 2 * RADIUS + 1> group;
+            std::copy(&values[startIdx], &values[endIdx], group.begin());
+            std::sort(group.begin(), std::next(group.begin(), endIdx - startIdx));
+            result[i] = group[RANK];
+        }
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK_TEMPLATE(BM_OffsetFilter_Sort, float);
+BENCHMARK_TEMPLATE(BM_OffsetFilter_Sort, q15_t);
+
+// Benchmark offset filter stage with a sorted window sliding along the sensors
+template <typename T>
+static void BM_OffsetFilter_SortedWindow(benchmark::State& state) {
+    T values[cfg::NUM_SENSORS];
+    T result[cfg::NUM_SENSORS];
+    createIntensities(values);
+
+    for (auto _ : state) {
+        slidingOrderStatistic<RADIUS, RANK>(values, cfg::NUM_SENSORS, result);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK_TEMPLATE(BM_OffsetFilter_SortedWindow, float);
+BENCHMARK_TEMPLATE(BM_OffsetFilter_SortedWindow, q15_t);
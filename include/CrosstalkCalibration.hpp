@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SensorData.hpp>
+
+// Measurements of a crosstalk calibration frame, the LEDs are lit one at a time
+struct CrosstalkMeasurements {
+    Measurements dark;     // all LEDs are off
+    Measurements lit;      // only the LED of the sensor is lit
+    Measurements litLeft;  // only the LED STRIDE sensors left of the sensor is lit
+    Measurements litRight; // only the LED STRIDE sensors right of the sensor is lit
+};
+
+// Calculates the crosstalk of the sensors lit in parallel from the sums of
+// cfg::CROSSTALK_CALIB_FRAMES calibration frames. The crosstalk of a sensor from a neighbour is the
+// light it measures from the LED of the neighbour, relative to the light the neighbour measures.
+// Measurements decrease with the light, so the light is the drop of a measurement below the dark
+// one. Crosstalk gains are clamped to cfg::CROSSTALK_MAX_GAIN, the crosstalk of the sensors without
+// measurable light is 0.
+class CrosstalkCalibration {
+  public:
+    // sensors lit in parallel are NUM_SENSORS / NUM_PARALLEL_SENSORS apart, see SensorHandler
+    explicit CrosstalkCalibration(
+        const uint8_t stride = cfg::NUM_SENSORS / cfg::NUM_PARALLEL_SENSORS);
+
+    void update(const CrosstalkMeasurements& measurements);
+
+    bool isCalibrated() const { return this->numFrames_ == cfg::CROSSTALK_CALIB_FRAMES; }
+
+    // the crosstalk of the calibration, no crosstalk is removed until it has finished
+    const Crosstalk& crosstalk() const { return this->crosstalk_; }
+
+  private:
+    uint16_t gain(const uint32_t leakSum, const uint8_t sourceIdx) const;
+
+    const uint8_t stride_;
+    uint16_t numFrames_ = 0;
+    std::array<uint32_t, cfg::NUM_SENSORS> darkSums_{};
+    std::array<uint32_t, cfg::NUM_SENSORS> litSums_{};
+    std::array<uint32_t, cfg::NUM_SENSORS> litLeftSums_{};
+    std::array<uint32_t, cfg::NUM_SENSORS> litRightSums_{};
+    Crosstalk crosstalk_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+#include <micro/utils/types.hpp>
+
+// Flash memory area, that can only be erased as a whole.
+// Erasing sets all the bytes to 0xff, writing can only clear bits.
+class Flash {
+  public:
+    virtual ~Flash() = default;
+
+    virtual uint32_t size() const = 0;
+
+    virtual void read(const uint32_t offset, void* const OUT data, const uint32_t size) const = 0;
+    virtual bool write(const uint32_t offset, const void* const data, const uint32_t size) = 0;
+    virtual bool erase() = 0;
+};
+
+// Sector of the internal flash of the microcontroller
+class FlashSector : public Flash {
+  public:
+    FlashSector(const uint32_t sector, const uint32_t address, const uint32_t size);
+
+    uint32_t size() const override { return this->size_; }
+
+    void read(const uint32_t offset, void* const OUT data, const uint32_t size) const override;
+    bool write(const uint32_t offset, const void* const data, const uint32_t size) override;
+    bool erase() override;
+
+  private:
+    const uint32_t sector_;
+    const uint32_t address_;
+    const uint32_t size_;
+};
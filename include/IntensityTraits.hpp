@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+
+#include <micro/math/numeric.hpp>
+
+// Q1.15 fixed-point value, same representation as the CMSIS-DSP q15_t type
+typedef int16_t q15_t;
+
+template <typename T>
+struct IntensityTraits;
+
+// Floating-point intensities: 0.0f means white (no line), 1.0f means full line intensity
+template <>
+struct IntensityTraits<float> {
+    using accumulator_t = float;
+
+    static constexpr float ONE = 1.0f;
+
+    static constexpr float fromFloat(const float value) { return value; }
+    static constexpr float toFloat(const float value) { return value; }
+
+    // maps a weight of a weighted sum to the accumulator domain
+    static constexpr float weight(const float w) { return w; }
+
+    // maps a weight of a weighted average to the accumulator domain, normalized by the weight sum
+    static constexpr float averageWeight(const float w, const float sumWeight) {
+        return w / sumWeight;
+    }
+
+    static constexpr float fromAverage(const float average) { return average; }
+
+    // per-sensor reciprocal of the measurement range above the white level
+    using gain_t = float;
+
+    static float scale(const uint8_t measurement, const uint8_t whiteLevel) {
+        return micro::lerp<uint8_t>(measurement, whiteLevel, 255, 0.0f, 1.0f);
+    }
+
+    static float gain(const uint8_t whiteLevel) {
+        return 1.0f / static_cast<float>(micro::max<int32_t>(255 - whiteLevel, 1));
+    }
+
+    static float scale(const uint8_t measurement, const uint8_t whiteLevel, const float gain) {
+        return static_cast<float>(micro::max<int32_t>(measurement - whiteLevel, 0)) * gain;
+    }
+
+    static float removeOffset(const float value, const float offset) {
+        return micro::lerp(value, offset, ONE, 0.0f, ONE);
+    }
+};
+
+// Q15 fixed-point intensities: 0 means white (no line), 0x7fff means full line intensity.
+// Weights of weighted sums are stored in Q8 format, so a sum fits into 32 bits for any sensible
+// radius. Normalized weights of weighted averages are stored in Q15 format.
+// Gains are stored in Q16 format. As the difference from the white level never exceeds the range,
+// the scaled product fits into 32 bits.
+template <>
+struct IntensityTraits<q15_t> {
+    using accumulator_t = int32_t;
+
+    static constexpr q15_t ONE = 0x7fff;
+
+    static constexpr q15_t fromFloat(const float value) {
+        return static_cast<q15_t>(value * ONE + 0.5f);
+    }
+
+    static constexpr float toFloat(const q15_t value) { return value / static_cast<float>(ONE); }
+
+    static constexpr int32_t weight(const float w) { return static_cast<int32_t>(w * 256 + 0.5f); }
+
+    static constexpr int32_t averageWeight(const float w, const float sumWeight) {
+        return static_cast<int32_t>(w / sumWeight * 32768 + 0.5f);
+    }
+
+    static constexpr q15_t fromAverage(const int32_t average) {
+        return static_cast<q15_t>((average + (1 << 14)) >> 15);
+    }
+
+    static constexpr q15_t scale(const uint8_t measurement, const uint8_t whiteLevel) {
+        const int32_t range = 255 - whiteLevel;
+        return measurement <= whiteLevel
+                   ? 0
+                   : static_cast<q15_t>(
+                         (static_cast<int32_t>(measurement - whiteLevel) * ONE + range / 2) /
+                         range);
+    }
+
+    using gain_t = uint32_t;
+
+    static constexpr uint32_t gain(const uint8_t whiteLevel) {
+        const uint32_t range = micro::max<int32_t>(255 - whiteLevel, 1);
+        return (static_cast<uint32_t>(ONE) * 65536 + range / 2) / range;
+    }
+
+    static constexpr q15_t scale(const uint8_t measurement, const uint8_t whiteLevel,
+                                 const uint32_t gain) {
+        return measurement <= whiteLevel
+                   ? 0
+                   : static_cast<q15_t>(
+                         (static_cast<uint32_t>(measurement - whiteLevel) * gain + (1u << 15)) >>
+                         16);
+    }
+
+    static constexpr q15_t removeOffset(const q15_t value, const q15_t offset) {
+        const int32_t range = ONE - offset;
+        return value <= offset
+                   ? 0
+                   : static_cast<q15_t>((static_cast<int32_t>(value - offset) * ONE + range / 2) /
+                                        range);
+    }
+};
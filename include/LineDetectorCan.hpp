@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+// CAN frames of the line detector panels, that are not part of the vehicle CAN protocol
+namespace can {
+
+// Requests a new white level calibration from the line detector panels, has no payload
+struct LineDetectRecalibrate {
+    static constexpr uint32_t id() { return 0x4a0; }
+};
+
+// Number of frames of each frame class (Normal, NoLine, Saturated, SensorFault) since the previous
+// report, sent with the line statistics
+template <uint32_t ID>
+struct LineFrameClasses {
+    static constexpr uint8_t NUM_CLASSES = 4;
+
+    uint16_t counts[NUM_CLASSES];
+
+    explicit LineFrameClasses(const std::array<uint16_t, NUM_CLASSES>& counts) {
+        std::copy(counts.begin(), counts.end(), this->counts);
+    }
+
+    static constexpr uint32_t id() { return ID; }
+};
+
+using FrontLineFrameClasses = LineFrameClasses<0x4a1>;
+using RearLineFrameClasses  = LineFrameClasses<0x4a2>;
+
+// Bits of the line sensors flagged as faulty by the sensor health monitor, sent when they change
+template <uint32_t ID>
+struct LineSensorHealth {
+    uint64_t faultySensors;
+
+    explicit LineSensorHealth(const uint64_t faultySensors) : faultySensors(faultySensors) {}
+
+    static constexpr uint32_t id() { return ID; }
+};
+
+using FrontLineSensorHealth = LineSensorHealth<0x4a3>;
+using RearLineSensorHealth  = LineSensorHealth<0x4a4>;
+
+} // namespace can
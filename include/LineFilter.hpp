@@ -1,40 +1,56 @@
 #pragma once
 
 #include <LinePosCalculator.hpp>
+#include <TrackedLineState.hpp>
 #include <cfg_sensor.hpp>
 
-#include <etl/circular_buffer.h>
-
 #include <micro/container/set.hpp>
+#include <micro/container/vector.hpp>
+#include <micro/math/numeric.hpp>
 #include <micro/math/unit_utils.hpp>
 #include <micro/utils/Line.hpp>
 
 #define TRACKED_LINE_ID_INVALID 0
 #define TRACKED_LINE_ID_MAX 7
 
-class LineFilter {
+// Tracks the detected lines over the frames, and assigns ids to them.
+// Lines are only reported after they have been detected in LINE_FILTER_HYSTERESIS frames,
+// and they are kept for LINE_FILTER_HYSTERESIS frames after they have disappeared.
+// MAX_LINES is the number of the tracked lines, including the ones not validated yet, and the line
+// state selects the estimation of their positions and velocities, see TrackedLineState.hpp.
+template <size_t MAX_LINES, typename line_state_t>
+class BasicLineFilter {
   public:
-    micro::Lines update(const LinePositions& detectedLines, const size_t maxLines);
+    static_assert(MAX_LINES <= TRACKED_LINE_ID_MAX, "Line ids must be unique");
+
+    // The time of the frame is only needed for the prediction of the lines,
+    // frames without time are not used to measure the frame period.
+    micro::Lines update(const LinePositions& detectedLines, const size_t maxLines,
+                        const micro::millisecond_t time = micro::millisecond_t(0));
+    void update(const LinePositions& detectedLines, const size_t maxLines,
+                micro::Lines& OUT validLines,
+                const micro::millisecond_t time = micro::millisecond_t(0));
+
+    // Extrapolates the lines reported by the last update to the given time, using the velocities
+    // of the tracked lines and the average frame period. Lines are kept at their reported
+    // positions until the frame period is known.
+    micro::Lines predict(const micro::Lines& lines, const micro::millisecond_t time) const;
 
   private:
     struct FilteredLine {
         uint8_t id = 0;
-        etl::circular_buffer<micro::millimeter_t, 100> samples;
-        micro::millimeter_t estimated;
+        line_state_t state;
         int8_t cntr      = 0;
         bool isValidated = false;
 
-        micro::millimeter_t current() const;
-
-        micro::millimeter_t current_raw() const {
-            return samples.empty() ? micro::millimeter_t(0) : samples.back();
-        }
+        FilteredLine() : FilteredLine(micro::millimeter_t(0)) {}
+        explicit FilteredLine(const micro::millimeter_t pos) : state(pos) {}
 
         bool operator<(const FilteredLine& other) const {
-            return current_raw() < other.current_raw();
+            return state.position() < other.state.position();
         }
         bool operator>(const FilteredLine& other) const {
-            return current_raw() > other.current_raw();
+            return state.position() > other.state.position();
         }
 
         void increaseCntr() {
@@ -48,9 +64,224 @@ class LineFilter {
         }
     };
 
-    using FilteredLines = micro::set<FilteredLine, cfg::MAX_NUM_FILTERED_LINES>;
+    using FilteredLines = micro::set<FilteredLine, MAX_LINES>;
+
+    // a detected line, or the expected position of a filtered line
+    struct Track {
+        micro::millimeter_t pos;
+        FilteredLine* filteredLine = nullptr; // nullptr for the detected lines
+
+        bool isDetected() const { return !filteredLine; }
+    };
+
+    using Tracks = micro::vector<Track, micro::Line::MAX_NUM_LINES + MAX_LINES>;
+
+    void mergeTracks(const LinePositions& detectedLines, Tracks& OUT tracks);
 
     uint8_t generateNewLineId();
 
+    void updateFrameTime(const micro::millisecond_t time);
+
     FilteredLines lines_;
+    uint8_t usedIds_ = 1 << TRACKED_LINE_ID_INVALID; // bit mask of the ids of the filtered lines
+
+    micro::millisecond_t frameTime_;   // time of the last timed frame
+    micro::millisecond_t framePeriod_; // average period of the timed frames, 0 when not known yet
 };
+
+template <size_t MAX_LINES, typename line_state_t>
+micro::Lines BasicLineFilter<MAX_LINES, line_state_t>::update(const LinePositions& detectedLines,
+                                                              const size_t maxLines,
+                                                              const micro::millisecond_t time) {
+    micro::Lines validLines;
+    this->update(detectedLines, maxLines, validLines, time);
+    return validLines;
+}
+
+template <size_t MAX_LINES, typename line_state_t>
+void BasicLineFilter<MAX_LINES, line_state_t>::update(const LinePositions& detectedLines,
+                                                      const size_t maxLines,
+                                                      micro::Lines& OUT validLines,
+                                                      const micro::millisecond_t time) {
+    this->updateFrameTime(time);
+
+    // predicts the positions of all filtered lines
+    for (FilteredLine& l : this->lines_) {
+        l.state.predict();
+    }
+
+    Tracks tracks;
+    this->mergeTracks(detectedLines, tracks);
+
+    // The closest pair of a detected line and an expected position is always adjacent in the
+    // merged order, so only the adjacent pairs are compared. Pairs are accepted while they are
+    // close enough to each other, the closest one first. When a pair is removed, only its
+    // neighbours become adjacent, so the order of the remaining tracks is kept.
+    while (true) {
+        typename Tracks::iterator closest = tracks.end();
+        micro::millimeter_t minDiff       = cfg::MAX_LINE_JUMP;
+
+        for (typename Tracks::iterator it = tracks.begin(); tracks.end() - it >= 2; ++it) {
+            const typename Tracks::iterator next = std::next(it);
+            if (it->isDetected() != next->isDetected() && next->pos - it->pos < minDiff) {
+                minDiff = next->pos - it->pos;
+                closest = it;
+            }
+        }
+
+        if (closest == tracks.end()) {
+            break;
+        }
+
+        // of the filtered lines expected at the same position the first one is matched
+        if (!closest->isDetected()) {
+            typename Tracks::iterator first = closest;
+            while (first != tracks.begin() && !std::prev(first)->isDetected() &&
+                   std::prev(first)->pos == closest->pos) {
+                --first;
+            }
+            std::rotate(first, std::next(first), std::next(closest));
+        }
+
+        const typename Tracks::iterator next  = std::next(closest);
+        const micro::millimeter_t detectedPos = closest->isDetected() ? closest->pos : next->pos;
+        FilteredLine& filteredLine =
+            closest->isDetected() ? *next->filteredLine : *closest->filteredLine;
+
+        filteredLine.state.update(detectedPos);
+        filteredLine.increaseCntr();
+
+        // pair has been handled, removes them from the tracks
+        tracks.erase(tracks.erase(closest));
+    }
+
+    // decreases counters for unmatched previous lines
+    for (const Track& track : tracks) {
+        if (!track.isDetected()) {
+            track.filteredLine->decreaseCntr();
+            track.filteredLine->state.coast();
+        }
+    }
+
+    validLines.clear();
+
+    for (auto it = this->lines_.begin(); it != this->lines_.end();) {
+        // erases lines from the filtered lines list that have not been detected for a given number
+        // of measurements, and releases their ids
+        if (-cfg::LINE_FILTER_HYSTERESIS == it->cntr) {
+            this->usedIds_ &= ~(1 << it->id);
+            it = this->lines_.erase(it);
+        } else {
+            // if a line has been in the filtered lines list for at least LINE_FILTER_HYSTERESIS
+            // measurements, then it is a valid line
+            if (cfg::LINE_FILTER_HYSTERESIS == it->cntr) {
+                it->isValidated = true;
+            }
+
+            // output list will contain all validated lines from the filtered lines list
+            if (it->isValidated && validLines.size() < maxLines) {
+                validLines.insert({it->state.position(), it->id});
+            }
+
+            ++it;
+        }
+    }
+
+    // added unmatched detected lines to the filtered lines list
+    for (const Track& track : tracks) {
+        if (this->lines_.full()) {
+            break;
+        }
+
+        if (track.isDetected()) {
+            FilteredLine newLine(track.pos);
+            newLine.id          = this->generateNewLineId();
+            newLine.cntr        = 1;
+            newLine.isValidated = false;
+            this->lines_.insert(newLine);
+        }
+    }
+}
+
+template <size_t MAX_LINES, typename line_state_t>
+micro::Lines BasicLineFilter<MAX_LINES, line_state_t>::predict(
+    const micro::Lines& lines, const micro::millisecond_t time) const {
+    if (this->framePeriod_ == micro::millisecond_t(0)) {
+        return lines;
+    }
+
+    const float numFrames = (time - this->frameTime_) / this->framePeriod_;
+
+    micro::Lines predicted;
+    for (micro::Line line : lines) {
+        for (const FilteredLine& l : this->lines_) {
+            if (l.id == line.id) {
+                line.pos += l.state.velocity() * numFrames;
+                break;
+            }
+        }
+        predicted.insert(line);
+    }
+    return predicted;
+}
+
+// Merges the detected lines and the expected positions of the filtered lines in the order of
+// their positions. Both are sorted already, unless the filtered lines are expected to cross, so
+// the insertion sort of the expected positions is linear in the usual case.
+template <size_t MAX_LINES, typename line_state_t>
+void BasicLineFilter<MAX_LINES, line_state_t>::mergeTracks(const LinePositions& detectedLines,
+                                                           Tracks& OUT tracks) {
+    micro::vector<Track, MAX_LINES> expected;
+    for (FilteredLine& l : this->lines_) {
+        auto pos = expected.end();
+        while (pos != expected.begin() && std::prev(pos)->pos > l.state.predicted()) {
+            --pos;
+        }
+        expected.insert(pos, {l.state.predicted(), &l});
+    }
+
+    auto exp = expected.begin();
+    for (const LinePosition& detected : detectedLines) {
+        for (; exp != expected.end() && exp->pos < detected.pos; ++exp) {
+            tracks.push_back(*exp);
+        }
+        tracks.push_back({detected.pos, nullptr});
+    }
+    for (; exp != expected.end(); ++exp) {
+        tracks.push_back(*exp);
+    }
+}
+
+// allocates the lowest free id, TRACKED_LINE_ID_INVALID is never free
+template <size_t MAX_LINES, typename line_state_t>
+uint8_t BasicLineFilter<MAX_LINES, line_state_t>::generateNewLineId() {
+    const uint8_t id = __builtin_ctz(~this->usedIds_);
+    this->usedIds_ |= 1 << id;
+    return id;
+}
+
+// the frame period is averaged over the consecutive timed frames
+template <size_t MAX_LINES, typename line_state_t>
+void BasicLineFilter<MAX_LINES, line_state_t>::updateFrameTime(const micro::millisecond_t time) {
+    if (time == micro::millisecond_t(0)) {
+        return;
+    }
+
+    if (this->frameTime_ != micro::millisecond_t(0) && time > this->frameTime_) {
+        const micro::millisecond_t period = time - this->frameTime_;
+        if (this->framePeriod_ == micro::millisecond_t(0)) {
+            this->framePeriod_ = period;
+        } else {
+            this->framePeriod_ +=
+                (period - this->framePeriod_) * cfg::LINE_FILTER_FRAME_PERIOD_WEIGHT;
+        }
+    }
+    this->frameTime_ = time;
+}
+
+// the configurations of the panel are instantiated in LineFilter.cpp
+extern template class BasicLineFilter<cfg::MAX_NUM_FILTERED_LINES, SampleHistoryLineState>;
+extern template class BasicLineFilter<cfg::MAX_NUM_FILTERED_LINES, AlphaBetaLineState>;
+extern template class BasicLineFilter<cfg::MAX_NUM_FILTERED_LINES, KalmanLineState>;
+
+using LineFilter = BasicLineFilter<cfg::MAX_NUM_FILTERED_LINES, LINE_FILTER_STATE>;
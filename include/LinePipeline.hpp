@@ -0,0 +1,26 @@
+#pragma once
+
+#include <LineFilter.hpp>
+#include <LinePatternCalculator.hpp>
+#include <LinePosCalculator.hpp>
+
+// Line detection pipeline of the line calculation task:
+// line position calculation, line filtering and line pattern calculation.
+// Used for processing recorded frames in batches, e.g. for offline analysis.
+class LinePipeline {
+  public:
+    explicit LinePipeline(const bool whiteLevelCalibrationEnabled);
+
+    // Processes consecutive frames, and writes the filtered lines and the line pattern of each
+    // frame into the output arrays. Speeds are given in the direction of the panel.
+    void run(const micro::linePatternDomain_t domain, const size_t maxLines,
+             const Measurements* const measurements, const micro::meter_t* const distances,
+             const micro::m_per_sec_t* const speeds, const size_t numFrames,
+             micro::Lines* const OUT lines, micro::LinePattern* const OUT patterns);
+
+  private:
+    LinePosCalculator linePosCalc_;
+    LineFilter lineFilter_;
+    LinePatternCalculator linePatternCalc_;
+    LinePositions linePositions_;
+};
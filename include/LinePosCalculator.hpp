@@ -1,13 +1,14 @@
 #pragma once
 
+#include <array>
 #include <cmath>
 
+#include <IntensityTraits.hpp>
 #include <SensorData.hpp>
 #include <cfg_sensor.hpp>
 #include <utility>
 
 #include <micro/container/set.hpp>
-#include <micro/container/vector.hpp>
 #include <micro/math/numeric.hpp>
 #include <micro/utils/Line.hpp>
 #include <micro/utils/units.hpp>
@@ -22,17 +23,21 @@ struct WeightCalculator {
           lastWeight(radius - micro::floor(radius - 0.001f)),
           sumWeight(1.0f + 2 * (this->radius - 1 + this->lastWeight)) {}
 
-    constexpr WeightCalculator(const float radius, const uint8_t centerIdx)
-        : WeightCalculator(radius <= centerIdx ? radius : static_cast<float>(centerIdx)) {}
-
     constexpr float weight(const int8_t subIdx) const {
         return micro::abs(subIdx) == this->radius ? this->lastWeight : 1.0f;
     }
 };
 
+// Position of a detected line, with its edges where the intensity falls below half of the peak.
+// Lines detected in a blob that is much wider than a line, e.g. at a junction, share its edges.
+// The edges are diagnostics only, they are not passed on to the detected micro::Lines.
 struct LinePosition {
     micro::millimeter_t pos;
     float probability{};
+    micro::millimeter_t leftEdge{};
+    micro::millimeter_t rightEdge{};
+
+    micro::millimeter_t width() const { return this->rightEdge - this->leftEdge; }
 
     bool operator<(const LinePosition& other) const { return this->pos < other.pos; }
     bool operator>(const LinePosition& other) const { return this->pos > other.pos; }
@@ -40,46 +45,219 @@ struct LinePosition {
 
 using LinePositions = micro::set<LinePosition, micro::Line::MAX_NUM_LINES>;
 
-class LinePosCalculator {
+// Class of a frame, from a pre-pass over the raw measurements of the scan range.
+// Lines are only searched in normal frames.
+enum class frameClass_t : uint8_t {
+    Normal,     // the measurements may contain lines
+    NoLine,     // no measurement is high enough above its white level to be part of a line
+    Saturated,  // every measurement is at the maximum, lines cannot be distinguished
+    SensorFault // every measurement is 0, the sensors are not read
+};
+
+constexpr uint8_t NUM_FRAME_CLASSES = 4;
+
+// Estimators of the sub-sensor line position from the intensities around the peak sensor.
+// The fitted estimators fall back to the next one when the intensities cannot be fitted.
+enum class linePosEstimator_t : uint8_t {
+    Centroid, // weighted center of the group, biased toward the peak sensor
+    Parabola, // vertex of the parabola fitted to the peak and its neighbours
+    Gaussian  // center of the Gaussian fitted to the peak and its neighbours
+};
+
+// Search modes of the line candidates.
+enum class lineSearch_t : uint8_t {
+    Full,        // group intensities are calculated and searched in the whole scan range
+    CoarseToFine // only around the sensors that may be part of a line, see BasicLinePosCalculator
+};
+
+// Line detection engines, that can be selected at runtime, e.g. for each line pattern domain.
+enum class lineDetector_t : uint8_t {
+    GroupIntensity, // removes the local offsets, and ranks the weighted groups of the intensities
+    MatchedFilter   // correlates the scaled measurements with the zero-mean line profile
+};
+
+// Calculates line positions from the raw sensor measurements.
+// The intensity type selects the arithmetic of the calculation: float or Q15 fixed-point.
+// The fixed-point variant produces the same line positions as the float variant within 0.5mm,
+// and the same probabilities within 0.01. When two adjacent sensor groups are equal within the Q15
+// resolution, the peak may be assigned to the other group, moving the position by at most one
+// sensor pitch.
+// Only the sensors of the scan range are processed, the rest are treated as not measured.
+// White level calibration only uses full scans.
+// When white level adaptation is enabled, the white levels follow the lighting changes
+// continuously, using the measurements of the sensors that are not near any detected line.
+// Intermediate results are kept between frames, and only recalculated around the sensors whose
+// measurements or white levels changed, so the results equal a full recalculation of the frame.
+// A measurement deadband above 0 also skips the smaller changes, treating them as noise: the
+// previous measurement of the sensor is used until the deadband is exceeded, so the results may
+// differ from a full recalculation.
+// Frames are classified while the changed measurements are detected, the rest of the calculation
+// is skipped for frames without lines.
+// In coarse-to-fine search mode the sensors that may be part of a line are marked while the frame
+// is classified, and the intensities, group intensities and candidates are only calculated around
+// them, so the cost scales with the number of lines instead of the array size. The weakest searched
+// group is used instead of the weakest group of the scan range, and the unsearched sensors are
+// counted at the line threshold, so the probabilities of the lines may be slightly lower, but never
+// higher than in full search mode. If no line is found around the marked sensors, the whole scan
+// range is searched.
+// The matched filter detector skips the offset filter and the group intensities: it correlates the
+// scaled measurements with a Gaussian line profile, whose mean is removed so that constant offsets
+// have no response. The line search mode only applies to the group intensity detector.
+// The sensor array type describes the panel (see SensorArray), all buffers are sized for its
+// sensors at compile-time.
+template <typename intensity_t, typename sensor_array_t = PanelSensorArray>
+class BasicLinePosCalculator {
   public:
-    explicit LinePosCalculator(const bool whiteLevelCalibrationEnabled);
+    static constexpr uint8_t NUM_SENSORS = sensor_array_t::NUM_SENSORS;
+    static_assert(NUM_SENSORS <= 64, "Sensor sets of the calculation are stored in 64-bit masks");
+
+    using Measurements = typename sensor_array_t::Measurements;
+    using Crosstalk    = typename sensor_array_t::Crosstalk;
+
+    explicit BasicLinePosCalculator(
+        const bool whiteLevelCalibrationEnabled, const bool whiteLevelAdaptationEnabled = false,
+        const linePosEstimator_t linePosEstimator = linePosEstimator_t::Centroid,
+        const lineSearch_t lineSearch             = lineSearch_t::Full);
+
+    LinePositions calculate(const Measurements& measurements, const size_t maxLines,
+                            const ScanRange& scanRange = sensor_array_t::FULL_SCAN_RANGE);
+
+    void calculate(const Measurements& measurements, const size_t maxLines,
+                   LinePositions& OUT positions,
+                   const ScanRange& scanRange = sensor_array_t::FULL_SCAN_RANGE);
+
+    // Calculates the line positions of consecutive frames, e.g. for offline analysis
+    void calculate(const Measurements* const measurements, const size_t numFrames,
+                   const size_t maxLines, LinePositions* const OUT positions);
+
+    bool isWhiteLevelCalibrated() const { return this->whiteLevelCalibrated_; }
+
+    // Sets the white levels of a previous calibration, the calibration is skipped.
+    void setWhiteLevels(const Measurements& whiteLevels);
+
+    // Discards the white levels and starts a new calibration, if the calibration is enabled.
+    void restartWhiteLevelCalibration();
+
+    const Measurements& whiteLevels() const { return this->whiteLevels_; }
 
-    LinePositions calculate(const Measurements& measurements, const size_t maxLines);
+    // Class of the last frame, that the lines were calculated for
+    frameClass_t frameClass() const { return this->frameClass_; }
+
+    // Selects the line detector of the next frames, the intermediate results are recalculated.
+    void setLineDetector(const lineDetector_t lineDetector);
+
+    lineDetector_t lineDetector() const { return this->lineDetector_; }
+
+    // Sets the crosstalk of the sensors lit in parallel, e.g. from a CrosstalkCalibration.
+    // The crosstalk is removed from the raw measurements before any other processing.
+    void setCrosstalk(const Crosstalk& crosstalk);
+
+    // Masks the faulty sensors, e.g. the ones flagged by the SensorHealthMonitor.
+    // Masked sensors are not used for the frame classification, their scaled measurements are
+    // interpolated between the nearest healthy sensors, so they do not cause or split lines.
+    void setMaskedSensors(const uint64_t maskedSensors);
+
+    uint64_t maskedSensors() const { return this->maskedSensors_; }
 
     static micro::millimeter_t optoIdxToLinePos(const float optoIdx);
     static float linePosToOptoPos(const micro::millimeter_t linePos);
 
   private:
+    using traits        = IntensityTraits<intensity_t>;
+    using accumulator_t = typename traits::accumulator_t;
+
+    static constexpr uint8_t GROUP_INTENSITY_RADIUS =
+        static_cast<uint8_t>(micro::ceil(cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS));
+
+    static constexpr uint8_t MATCHED_FILTER_RADIUS = cfg::LINE_POS_CALC_MATCHED_FILTER_RADIUS;
+
     struct groupIntensity_t {
         uint8_t centerIdx;
-        float intensity;
+        intensity_t intensity;
 
-        bool operator<(const groupIntensity_t& other) const {
-            return this->intensity < other.intensity;
-        }
-        bool operator>(const groupIntensity_t& other) const {
-            return this->intensity > other.intensity;
+        // stronger groups are ranked first, equal groups are ranked by their indexes
+        bool ranksBefore(const groupIntensity_t& other) const {
+            return this->intensity > other.intensity ||
+                   (this->intensity == other.intensity && this->centerIdx < other.centerIdx);
         }
     };
 
-    using groupIntensities_t =
-        micro::vector<groupIntensity_t,
-                      cfg::NUM_SENSORS - 2 * static_cast<size_t>(micro::ceil(
-                                                 cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS))>;
+    void runCalculation(const Measurements& measurements, const size_t maxLines,
+                        const ScanRange& scanRange, LinePositions& OUT positions);
 
-    LinePositions runCalculation(const Measurements& measurements, const size_t maxLines);
+    const Measurements& removeCrosstalk(const Measurements& measurements,
+                                        const ScanRange& scanRange);
 
     void runCalibration(const Measurements& measurements, const size_t maxLines);
 
+    bool isWhiteLevelCalibrationConverged() const;
+
     void updateInvalidWhiteLevels(const LinePositions& linePositions);
 
-    void normalize(const Measurements& measurements, float* const OUT result);
+    void applyWhiteLevels();
 
-    static groupIntensities_t calculateGroupIntensities(const float* const intensities);
-    static micro::millimeter_t calculateLinePos(const float* const intensities,
-                                                const uint8_t centerIdx);
+    void adaptWhiteLevels(const Measurements& measurements, const ScanRange& scanRange,
+                          const LinePositions& linePositions);
+
+    bool updateMeasurements(const Measurements& measurements, const ScanRange& scanRange);
+    uint64_t interpolateMaskedSensors(const ScanRange& scanRange, const uint64_t changedSensors);
+
+    void runGroupIntensityDetector(const ScanRange& scanRange, const size_t maxLines,
+                                   LinePositions& OUT positions);
+
+    void runMatchedFilterDetector(const ScanRange& scanRange, const size_t maxLines,
+                                  LinePositions& OUT positions);
+
+    void updateGroupIntensities(const ScanRange& scanRange, const uint64_t groups);
+
+    void findLines(const ScanRange& scanRange, const uint64_t groups, const size_t maxLines,
+                   LinePositions& OUT positions) const;
+
+    void selectLines(const ScanRange& scanRange, const intensity_t* const ranks,
+                     const intensity_t* const intensities, const uint64_t candidates,
+                     const float minRank, const float maxRank, const size_t maxLines,
+                     LinePositions& OUT positions) const;
+
+    micro::millimeter_t calculateLinePos(const intensity_t* const intensities,
+                                         const uint8_t centerIdx) const;
 
     bool whiteLevelCalibrationEnabled_;
+    bool whiteLevelAdaptationEnabled_;
+    linePosEstimator_t linePosEstimator_;
+    lineSearch_t lineSearch_;
+    lineDetector_t lineDetector_ = lineDetector_t::GroupIntensity;
     Measurements whiteLevels_;
-    micro::vector<Measurements, 200> whiteLevelCalibrationBuffer_;
+    std::array<typename traits::gain_t, NUM_SENSORS> gains_;
+    std::array<uint16_t, NUM_SENSORS> whiteLevelEstimates_; // Q8 format
+    bool whiteLevelCalibrated_ = false;
+    uint16_t numWhiteLevelCalibrationFrames_ = 0;
+    std::array<uint32_t, NUM_SENSORS> whiteLevelSums_{};
+    std::array<uint32_t, NUM_SENSORS> whiteLevelSquareSums_{};
+    Crosstalk crosstalk_;
+    Measurements compensated_;
+
+    // intermediate results of the scan range, calculated from the cached measurements
+    bool cacheValid_ = false;
+    ScanRange cachedScanRange_;
+    Measurements cachedMeasurements_;
+    uint64_t staleSensors_     = 0; // sensors to rescale, e.g. after a white level change
+    uint64_t staleIntensities_ = 0; // sensors to recalculate the intensities of, when needed
+    uint64_t staleGroups_      = 0; // groups to recalculate, when needed
+    uint64_t lineSensors_      = 0; // sensors that may be part of a line
+    uint64_t maskedSensors_    = 0; // faulty sensors, interpolated from their neighbours
+    std::array<intensity_t, NUM_SENSORS> scaled_;
+    std::array<intensity_t, NUM_SENSORS> offsets_;
+    std::array<intensity_t, NUM_SENSORS> intensities_;
+    std::array<intensity_t, NUM_SENSORS> groupIntensities_;
+    std::array<intensity_t, NUM_SENSORS + 2 * MATCHED_FILTER_RADIUS> paddedScaled_;
+    std::array<intensity_t, NUM_SENSORS + 2 * MATCHED_FILTER_RADIUS> responses_;
+    frameClass_t frameClass_ = frameClass_t::Normal;
+    size_t cachedMaxLines_   = 0;
+    LinePositions cachedPositions_;
 };
+
+#if LINE_POS_CALC_FIXED_POINT
+using LinePosCalculator = BasicLinePosCalculator<q15_t>;
+#else
+using LinePosCalculator = BasicLinePosCalculator<float>;
+#endif
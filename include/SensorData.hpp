@@ -2,15 +2,74 @@
 
 #include <array>
 #include <cfg_sensor.hpp>
+#include <utility>
 
+#include <micro/math/numeric.hpp>
 #include <micro/utils/types.hpp>
+#include <micro/utils/units.hpp>
 
-typedef std::array<uint8_t, cfg::NUM_SENSORS> Measurements;
+// inclusive index range of the scanned sensors
+typedef std::pair<uint8_t, uint8_t> ScanRange;
+
+// Optical crosstalk of the sensors lit in parallel. Sensors STRIDE apart are lit at the same time,
+// each sensor also measures fractions of the light of the lit sensors next to it, given in Q16
+// format. Crosstalk of the farther lit sensors is neglected.
+// Measurements decrease with the light, the light of a sensor is its drop below its dark level.
+template <uint8_t N>
+struct SensorCrosstalk {
+    uint8_t stride = 0;            // 0 if there is no crosstalk to remove
+    std::array<uint8_t, N> dark{}; // measurements with all LEDs off
+    std::array<uint16_t, N> left{};
+    std::array<uint16_t, N> right{};
+};
+
+// Describes a line sensor array by its number of sensors and the distance of the adjacent sensors
+// in micrometers. The buffers of the line position calculation are sized from it at compile-time.
+template <uint8_t N, uint32_t PITCH_UM>
+struct SensorArray {
+    static constexpr uint8_t NUM_SENSORS = N;
+    static constexpr micro::millimeter_t LENGTH =
+        micro::millimeter_t((N - 1) * PITCH_UM / 1000.0f); // distance of the first and last sensor
+    static constexpr ScanRange FULL_SCAN_RANGE = {0, N - 1};
+
+    typedef std::array<uint8_t, N> Measurements;
+    typedef SensorCrosstalk<N> Crosstalk;
+};
+
+using PanelSensorArray = SensorArray<cfg::NUM_SENSORS, cfg::OPTO_SENSOR_PITCH_UM>;
+
+// prototype panels with the sensors of the current panel
+using SensorArray32 = SensorArray<32, cfg::OPTO_SENSOR_PITCH_UM>;
+using SensorArray64 = SensorArray<64, cfg::OPTO_SENSOR_PITCH_UM>;
+
+typedef PanelSensorArray::Measurements Measurements;
+typedef PanelSensorArray::Crosstalk Crosstalk;
 typedef std::array<bool, cfg::NUM_SENSORS> Leds;
 
+// measurements of a frame, with the time in the middle of their readout
+struct TimedMeasurements {
+    Measurements measurements;
+    micro::millisecond_t time;
+};
+
+constexpr ScanRange FULL_SCAN_RANGE = PanelSensorArray::FULL_SCAN_RANGE;
+
 struct SensorControlData {
     Leds leds;
     bool scanEnabled        = false;
     uint8_t scanRangeCenter = cfg::NUM_SENSORS / 2;
     uint8_t scanRangeRadius = 0;
+
+    ScanRange scanRange() const {
+        ScanRange range = FULL_SCAN_RANGE;
+
+        if (this->scanRangeRadius > 0) {
+            range.first =
+                micro::max(this->scanRangeCenter, this->scanRangeRadius) - this->scanRangeRadius;
+            range.second = micro::min(this->scanRangeCenter + this->scanRangeRadius,
+                                      cfg::NUM_SENSORS - 1);
+        }
+
+        return range;
+    }
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <CrosstalkCalibration.hpp>
 #include <SensorData.hpp>
 #include <utility>
 
@@ -18,11 +19,14 @@ class SensorHandler {
     void initialize();
 
     void readSensors(Measurements& OUT measurements, const std::pair<uint8_t, uint8_t>& scanRange);
+    void readCrosstalk(CrosstalkMeasurements& OUT measurements);
     void writeLeds(const Leds& leds);
 
     void onTxFinished();
 
   private:
+    void lightUp(const uint8_t* const selectors);
+    uint8_t readSensor(const uint8_t sensorIdx);
     uint8_t readAdc(const uint8_t channel);
     void exchangeData(const uint8_t* txBuf, uint8_t* rxBuf, const uint32_t size);
 
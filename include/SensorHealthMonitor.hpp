@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SensorData.hpp>
+
+// Health of a line sensor, evaluated from the statistics of its measurements
+enum class sensorHealth_t : uint8_t {
+    Ok,
+    StuckHigh, // the measurement does not change while the adjacent ones do, and it is high
+    StuckLow,  // the measurement does not change while the adjacent ones do, and it is low
+    Noisy      // the measurement changes much more between frames than the adjacent ones
+};
+
+// Tracks the health of the line sensors with running statistics of the scanned measurements:
+// the range of each sensor, and its frame-to-frame change in excess of the adjacent sensors.
+// The statistics are evaluated at the end of every window of cfg::SENSOR_HEALTH_WINDOW_FRAMES
+// frames. Sensors that were scanned in less than half of the window keep their previous health.
+// Health is only tracked for the panel, the calculator gets the faulty sensors as a mask.
+class SensorHealthMonitor {
+  public:
+    SensorHealthMonitor();
+
+    void update(const Measurements& measurements, const ScanRange& scanRange);
+
+    sensorHealth_t health(const uint8_t sensorIdx) const { return this->health_[sensorIdx]; }
+
+    // bits of the sensors that are not healthy
+    uint64_t faultySensors() const { return this->faultySensors_; }
+
+  private:
+    struct Statistics {
+        uint8_t min;
+        uint8_t max;
+        uint16_t numFrames;
+        uint16_t numComparedFrames; // frames in which the change was compared to the neighbours
+        uint32_t excessChangeSum;
+    };
+
+    void evaluate();
+    void restartWindow();
+
+    std::array<sensorHealth_t, cfg::NUM_SENSORS> health_;
+    uint64_t faultySensors_ = 0;
+
+    std::array<Statistics, cfg::NUM_SENSORS> statistics_;
+    uint16_t numWindowFrames_ = 0;
+
+    Measurements prevMeasurements_ = {};
+    uint64_t prevScannedSensors_ = 0;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <IntensityTraits.hpp>
+
+#include <micro/utils/types.hpp>
+
+// Array operations of the line position calculation.
+// On Cortex-M4 targets the fixed-point kernels use the SIMD/DSP instructions,
+// on other platforms generic implementations are used, that can be vectorized by the compiler.
+namespace kernel {
+
+// Removes the crosstalk of the sensors lit in parallel: adds back the fractions (Q16) of the light
+// of the sensors STRIDE sensors left and right of each sensor, that is their drop below their dark
+// levels. Sensors outside the array have no crosstalk. Results are clamped to the measurement
+// range.
+void removeCrosstalk(const uint8_t* const measurements, const uint8_t* const darkLevels,
+                     const uint16_t* const leftGains, const uint16_t* const rightGains,
+                     const uint8_t stride, uint8_t* const OUT result, const uint8_t size);
+
+// Scales the raw measurements between the white levels (0) and the maximum measurement (ONE).
+// Gains are the IntensityTraits::gain values of the white levels, precomputed at calibration.
+void scale(const uint8_t* const measurements, const uint8_t* const whiteLevels,
+           const float* const gains, float* const OUT result, const uint8_t size);
+void scale(const uint8_t* const measurements, const uint8_t* const whiteLevels,
+           const uint32_t* const gains, q15_t* const OUT result, const uint8_t size);
+
+// Removes the offsets from the values, and scales the result between 0 and ONE
+void removeOffset(const float* const values, const float* const offsets, float* const OUT result,
+                  const uint8_t size);
+void removeOffset(const q15_t* const values, const q15_t* const offsets, q15_t* const OUT result,
+                  const uint8_t size);
+
+// Calculates the weighted average of the window of each value.
+// Weights are given for the subindexes [-RADIUS, RADIUS] as IntensityTraits::averageWeight values.
+// The result is written for the indexes [RADIUS, size - RADIUS), the rest is left untouched.
+// Instantiated for the radii of the group intensity calculation and the matched filter.
+template <uint8_t RADIUS>
+void weightedAverage(const float* const values, const float* const weights,
+                     float* const OUT result, const uint8_t size);
+template <uint8_t RADIUS>
+void weightedAverage(const q15_t* const values, const int32_t* const weights,
+                     q15_t* const OUT result, const uint8_t size);
+
+float sum(const float* const values, const uint8_t size);
+int32_t sum(const q15_t* const values, const uint8_t size);
+
+// Calculates the offset of the vertex of the parabola fitted to the 3 values of the window
+// from the center value. Returns false if the values do not form a peak within one sensor pitch.
+bool parabolaOffset(const float* const window, float& OUT offset);
+bool parabolaOffset(const q15_t* const window, float& OUT offset);
+
+// Calculates the offset of the center of the Gaussian fitted to the 3 values of the window
+// from the center value, using a logarithm lookup table. Returns false if any of the values is not
+// positive, or the values do not form a peak within one sensor pitch.
+bool gaussianOffset(const float* const window, float& OUT offset);
+bool gaussianOffset(const q15_t* const window, float& OUT offset);
+
+template <uint8_t RADIUS, typename T, size_t... K>
+float centerOffset(const T* const window,
+                   const typename IntensityTraits<T>::accumulator_t* const weights,
+                   std::index_sequence<K...>) {
+    using accumulator_t = typename IntensityTraits<T>::accumulator_t;
+
+    // indexes are relative to the center to keep the fixed-point weighted sum in range
+    const accumulator_t products[] = {(weights[K] * window[K])...};
+    const accumulator_t sum        = (... + products[K]);
+    const accumulator_t sumW = (... + (products[K] * (static_cast<int32_t>(K) - RADIUS)));
+    return static_cast<float>(sumW) / static_cast<float>(sum);
+}
+
+// Calculates the offset of the weighted center of the window from the center value.
+// Weights are given for the subindexes [-RADIUS, RADIUS] as IntensityTraits::weight values.
+// Defined in the header, so that the sums are unrolled, and constant weights are inlined.
+template <uint8_t RADIUS, typename T>
+float centerOffset(const T* const window,
+                   const typename IntensityTraits<T>::accumulator_t* const weights) {
+    return centerOffset<RADIUS>(window, weights, std::make_index_sequence<2 * RADIUS + 1>{});
+}
+
+} // namespace kernel
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <micro/utils/types.hpp>
+
+// Sorted fixed-capacity window of values, updated by inserting and evicting single values.
+// Used for calculating order statistics over a window sliding along an array.
+template <typename T, size_t N>
+class SortedWindow {
+  public:
+    size_t size() const { return this->size_; }
+
+    // precondition: window is not full
+    void insert(const T& value) {
+        size_t i = this->size_++;
+        for (; i > 0 && value < this->values_[i - 1]; --i) {
+            this->values_[i] = this->values_[i - 1];
+        }
+        this->values_[i] = value;
+    }
+
+    // precondition: value is in the window
+    void evict(const T& value) {
+        size_t i = 0;
+        while (this->values_[i] < value) {
+            ++i;
+        }
+        for (--this->size_; i < this->size_; ++i) {
+            this->values_[i] = this->values_[i + 1];
+        }
+    }
+
+    const T& operator[](const size_t rank) const { return this->values_[rank]; }
+
+  private:
+    std::array<T, N> values_;
+    size_t size_ = 0;
+};
+
+// Calculates the RANK-th smallest value of the window of the given radius around the elements
+// [begin, end). Windows are clamped to the array, therefore they contain at least RADIUS + 1
+// elements.
+template <uint8_t RADIUS, uint8_t RANK, typename T>
+void slidingOrderStatistic(const T* const values, const uint8_t size, const uint8_t begin,
+                           const uint8_t end, T* const OUT result) {
+    static_assert(RANK <= RADIUS, "Rank must be valid for the clamped windows at the array edges");
+
+    SortedWindow<T, 2 * RADIUS + 1> window;
+    const uint8_t windowEnd = std::min<uint8_t>(begin + RADIUS, size);
+    for (uint8_t i = std::max<uint8_t>(begin, RADIUS) - RADIUS; i < windowEnd; ++i) {
+        window.insert(values[i]);
+    }
+
+    for (uint8_t i = begin; i < end; ++i) {
+        if (i > begin && i > RADIUS) {
+            window.evict(values[i - RADIUS - 1]);
+        }
+        if (i + RADIUS < size) {
+            window.insert(values[i + RADIUS]);
+        }
+        result[i] = window[RANK];
+    }
+}
+
+template <uint8_t RADIUS, uint8_t RANK, typename T>
+void slidingOrderStatistic(const T* const values, const uint8_t size, T* const OUT result) {
+    slidingOrderStatistic<RADIUS, RANK>(values, size, 0, size, result);
+}
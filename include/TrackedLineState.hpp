@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include <cfg_sensor.hpp>
+
+#include <etl/circular_buffer.h>
+
+#include <micro/math/numeric.hpp>
+#include <micro/utils/units.hpp>
+
+// States of the lines tracked by the LineFilter, that estimate the position and the velocity of a
+// line from its detected positions. Velocities are given in millimeters per frame.
+// In each frame the state is predicted first, then it is either updated with the detected position
+// of the line, or coasts on the prediction if the line has not been detected.
+//
+// Interface of the states:
+//   explicit State(const micro::millimeter_t pos); // state of a newly detected line
+//   void predict();                                 // predicts the position of the next frame
+//   void update(const micro::millimeter_t pos);     // corrects the prediction with a detection
+//   void coast();                                   // keeps the prediction
+//   micro::millimeter_t predicted() const;          // predicted position, before update or coast
+//   micro::millimeter_t position() const;           // filtered position
+//   micro::millimeter_t velocity() const;
+
+// Keeps the history of the detected (or, when not detected, the predicted) positions.
+// The velocity is the change over the last VELO_FILTER_SIZE positions, the filtered position is the
+// average of the last POS_FILTER_WINDOW_SIZE positions. Only the positions needed by the filters
+// are kept.
+template <uint8_t VELO_FILTER_SIZE, uint8_t POS_FILTER_WINDOW_SIZE>
+class BasicSampleHistoryLineState {
+  public:
+    static_assert(VELO_FILTER_SIZE > 0 && POS_FILTER_WINDOW_SIZE > 0, "Invalid filter sizes");
+
+    static constexpr size_t DEPTH = std::max(VELO_FILTER_SIZE, POS_FILTER_WINDOW_SIZE);
+
+    explicit BasicSampleHistoryLineState(const micro::millimeter_t pos) {
+        this->samples_.push(pos);
+    }
+
+    void predict() { this->predicted_ = this->samples_.back() + this->velocity(); }
+
+    void update(const micro::millimeter_t pos) { this->samples_.push(pos); }
+
+    void coast() { this->samples_.push(this->predicted_); }
+
+    micro::millimeter_t predicted() const { return this->predicted_; }
+
+    micro::millimeter_t position() const {
+        const size_t size = std::min<size_t>(this->samples_.size(), POS_FILTER_WINDOW_SIZE);
+        const auto end    = std::next(this->samples_.rbegin(), size);
+        micro::millimeter_t pos;
+
+        for (auto it = this->samples_.rbegin(); it != end; ++it) {
+            pos += *it;
+        }
+        return pos / size;
+    }
+
+    micro::millimeter_t velocity() const {
+        return this->samples_.size() >= VELO_FILTER_SIZE
+                   ? (this->samples_.back() -
+                      *std::next(this->samples_.rbegin(), VELO_FILTER_SIZE - 1)) /
+                         VELO_FILTER_SIZE
+                   : micro::millimeter_t(0);
+    }
+
+  private:
+    etl::circular_buffer<micro::millimeter_t, DEPTH> samples_;
+    micro::millimeter_t predicted_;
+};
+
+using SampleHistoryLineState =
+    BasicSampleHistoryLineState<cfg::LINE_VELO_FILTER_SIZE, cfg::LINE_POS_FILTER_WINDOW_SIZE>;
+
+// Alpha-beta filter of the position and the velocity, with constant gains.
+// The velocity of a new line is initialized from its first two detections.
+class AlphaBetaLineState {
+  public:
+    explicit AlphaBetaLineState(const micro::millimeter_t pos) : pos_(pos) {}
+
+    void predict() { this->pos_ += this->velo_; }
+
+    void update(const micro::millimeter_t pos) {
+        const micro::millimeter_t residual = pos - this->pos_;
+        if (this->isVelocityInitialized_) {
+            this->pos_ += residual * cfg::LINE_FILTER_ALPHA;
+            this->velo_ += residual * cfg::LINE_FILTER_BETA;
+        } else {
+            this->pos_                   = pos;
+            this->velo_                  = residual;
+            this->isVelocityInitialized_ = true;
+        }
+    }
+
+    void coast() {}
+
+    micro::millimeter_t predicted() const { return this->pos_; }
+    micro::millimeter_t position() const { return this->pos_; }
+    micro::millimeter_t velocity() const { return this->velo_; }
+
+  private:
+    micro::millimeter_t pos_;
+    micro::millimeter_t velo_;
+    bool isVelocityInitialized_ = false;
+};
+
+// Kalman filter of the position and the velocity, with a constant velocity model and random
+// accelerations. The gains adapt to the covariance: new and coasting lines follow the detections
+// closely, lines tracked for a long time are smoothed like by the AlphaBetaLineState.
+// Covariances are stored in mm^2 units.
+class KalmanLineState {
+  public:
+    explicit KalmanLineState(const micro::millimeter_t pos)
+        : pos_(pos),
+          posVar_(cfg::LINE_FILTER_MEASUREMENT_VAR),
+          veloVar_(cfg::LINE_FILTER_INITIAL_VELO_VAR) {}
+
+    void predict() {
+        this->pos_ += this->velo_;
+        this->posVar_ += 2 * this->covar_ + this->veloVar_ + cfg::LINE_FILTER_ACCEL_VAR / 4;
+        this->covar_ += this->veloVar_ + cfg::LINE_FILTER_ACCEL_VAR / 2;
+        this->veloVar_ += cfg::LINE_FILTER_ACCEL_VAR;
+    }
+
+    void update(const micro::millimeter_t pos) {
+        const micro::millimeter_t residual = pos - this->pos_;
+
+        const float residualVar = this->posVar_ + cfg::LINE_FILTER_MEASUREMENT_VAR;
+        const float posGain     = this->posVar_ / residualVar;
+        const float veloGain    = this->covar_ / residualVar;
+
+        this->pos_ += residual * posGain;
+        this->velo_ += residual * veloGain;
+        this->veloVar_ -= veloGain * this->covar_;
+        this->covar_ -= posGain * this->covar_;
+        this->posVar_ -= posGain * this->posVar_;
+    }
+
+    void coast() {}
+
+    micro::millimeter_t predicted() const { return this->pos_; }
+    micro::millimeter_t position() const { return this->pos_; }
+    micro::millimeter_t velocity() const { return this->velo_; }
+
+  private:
+    micro::millimeter_t pos_;
+    micro::millimeter_t velo_;
+    float posVar_;
+    float covar_ = 0.0f;
+    float veloVar_;
+};
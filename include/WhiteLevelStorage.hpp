@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Flash.hpp>
+#include <SensorData.hpp>
+
+// Stores the white level calibration in flash, so that it can be reused after a restart.
+// Records are appended to the flash area. Erasing a flash sector stalls for seconds, so the area
+// is never erased by store(), it is compacted at startup instead, before it becomes full.
+// Records are validated by a tag, a layout version and a checksum,
+// the last valid record is loaded.
+class WhiteLevelStorage {
+  public:
+    explicit WhiteLevelStorage(Flash& flash);
+
+    bool load(Measurements& OUT whiteLevels) const;
+    bool store(const Measurements& whiteLevels);
+
+    // Erases the flash area when more than half of it is used, and keeps the last valid record.
+    bool compact();
+
+  private:
+    struct Record {
+        uint32_t tag;
+        uint16_t version;
+        uint16_t numSensors;
+        Measurements whiteLevels;
+        uint32_t checksum;
+    };
+
+    static uint32_t checksum(const Record& record);
+    uint32_t numSlots() const;
+    uint32_t firstFreeSlot() const;
+
+    Flash& flash_;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <Flash.hpp>
+
 #include <micro/port/can.hpp>
 #include <micro/port/gpio.hpp>
 #include <micro/port/spi.hpp>
@@ -73,6 +75,12 @@ extern UART_HandleTypeDef huart2;
         &huart2                                                                                    \
     }
 
+// last flash sector, reserved in the linker script
+#define flash_WhiteLevels                                                                          \
+    FlashSector {                                                                                  \
+        FLASH_SECTOR_7, 0x08060000, 128 * 1024                                                     \
+    }
+
 #define PANEL_VERSION_FRONT 0x01
 #define PANEL_VERSION_REAR 0x00
 
@@ -2,20 +2,54 @@
 
 #include <micro/utils/units.hpp>
 
+// Selects Q15 fixed-point arithmetic instead of float for the line position calculation
+#ifndef LINE_POS_CALC_FIXED_POINT
+#define LINE_POS_CALC_FIXED_POINT false
+#endif
+
+// Selects the state of the lines tracked by the line filter, see TrackedLineState.hpp
+#ifndef LINE_FILTER_STATE
+#define LINE_FILTER_STATE SampleHistoryLineState
+#endif
+
 namespace cfg {
 
 constexpr uint8_t MAX_NUM_FILTERED_LINES             = 6;
 constexpr uint8_t NUM_SENSORS                        = 48;
+constexpr uint8_t NUM_PARALLEL_SENSORS               = 6;
 constexpr uint8_t WHITE_LEVEL_LINE_GROUP_RADIUS      = 2;
+constexpr uint16_t WHITE_LEVEL_CALIB_MIN_FRAMES      = 50;
+constexpr uint16_t WHITE_LEVEL_CALIB_MAX_FRAMES      = 200;
+constexpr uint8_t WHITE_LEVEL_ADAPTATION_SHIFT       = 6;
+constexpr uint8_t WHITE_LEVEL_ADAPTATION_MAX_INCR    = 16;
 constexpr uint8_t LINE_POS_CALC_OFFSET_FILTER_RADIUS = 3;
 constexpr float LINE_POS_CALC_INTENSITY_GROUP_RADIUS = 0.5f;
 constexpr float LINE_POS_CALC_GROUP_RADIUS           = 1.0f;
+constexpr uint8_t LINE_POS_CALC_MEASUREMENT_DEADBAND = 0;
+constexpr uint8_t LINE_POS_CALC_MATCHED_FILTER_RADIUS = 3;
+constexpr float LINE_POS_CALC_MATCHED_FILTER_SIGMA   = 1.0f;
 constexpr micro::millimeter_t MAX_LINE_JUMP          = micro::millimeter_t(20);
 constexpr micro::millimeter_t MIN_LINE_DIST          = micro::millimeter_t(25);
 constexpr int8_t LINE_FILTER_HYSTERESIS              = 4;
 constexpr uint8_t LINE_VELO_FILTER_SIZE              = 4;
 constexpr uint8_t LINE_POS_FILTER_WINDOW_SIZE        = 1;
+constexpr float LINE_FILTER_ALPHA                    = 0.5f;
+constexpr float LINE_FILTER_BETA                     = 0.15f;
+constexpr float LINE_FILTER_MEASUREMENT_VAR          = 4.0f;   // mm^2
+constexpr float LINE_FILTER_ACCEL_VAR                = 0.25f;  // (mm/frame^2)^2
+constexpr float LINE_FILTER_INITIAL_VELO_VAR         = 100.0f; // (mm/frame)^2
+constexpr float LINE_FILTER_FRAME_PERIOD_WEIGHT      = 0.1f;   // weight of the last frame period
+constexpr micro::millisecond_t LINE_CAN_TX_LATENCY  = micro::millisecond_t(1); // send to receive
 constexpr float MIN_LINE_PROBABILITY                 = 0.40f;
-constexpr micro::millimeter_t OPTO_ARRAY_LENGTH      = micro::millimeter_t(274.574f);
+constexpr uint32_t OPTO_SENSOR_PITCH_UM              = 5842;
+constexpr bool CROSSTALK_COMPENSATION_ENABLED        = NUM_PARALLEL_SENSORS > 6; // 12 sensor mode
+constexpr uint8_t CROSSTALK_CALIB_FRAMES             = 16;
+constexpr uint16_t CROSSTALK_MAX_GAIN                = 0x8000; // Q16
+constexpr uint16_t SENSOR_HEALTH_WINDOW_FRAMES       = 256;
+constexpr uint8_t SENSOR_HEALTH_STUCK_MAX_RANGE      = 1;
+constexpr uint8_t SENSOR_HEALTH_ACTIVE_MIN_RANGE     = 64;
+constexpr uint8_t SENSOR_HEALTH_NOISY_MIN_CHANGE     = 16;
+constexpr micro::millimeter_t OPTO_ARRAY_LENGTH =
+    micro::millimeter_t((NUM_SENSORS - 1) * OPTO_SENSOR_PITCH_UM / 1000.0f);
 
 } // namespace cfg
@@ -0,0 +1,48 @@
+#include <CrosstalkCalibration.hpp>
+#include <algorithm>
+
+CrosstalkCalibration::CrosstalkCalibration(const uint8_t stride) : stride_(stride) {}
+
+void CrosstalkCalibration::update(const CrosstalkMeasurements& measurements) {
+    if (this->isCalibrated()) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        this->darkSums_[i] += measurements.dark[i];
+        this->litSums_[i] += measurements.lit[i];
+        this->litLeftSums_[i] += measurements.litLeft[i];
+        this->litRightSums_[i] += measurements.litRight[i];
+    }
+
+    if (++this->numFrames_ < cfg::CROSSTALK_CALIB_FRAMES) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        const uint32_t dark = this->darkSums_[i];
+
+        this->crosstalk_.dark[i] = (dark + this->numFrames_ / 2) / this->numFrames_;
+        this->crosstalk_.left[i] =
+            i >= this->stride_
+                ? this->gain(dark - std::min(this->litLeftSums_[i], dark), i - this->stride_)
+                : 0;
+        this->crosstalk_.right[i] =
+            i + this->stride_ < cfg::NUM_SENSORS
+                ? this->gain(dark - std::min(this->litRightSums_[i], dark), i + this->stride_)
+                : 0;
+    }
+    this->crosstalk_.stride = this->stride_;
+}
+
+// the light leaking from the source sensor's LED, relative to the light the source sensor measures
+uint16_t CrosstalkCalibration::gain(const uint32_t leakSum, const uint8_t sourceIdx) const {
+    const uint32_t dark   = this->darkSums_[sourceIdx];
+    const uint32_t signal = dark - std::min(this->litSums_[sourceIdx], dark);
+    if (!signal) {
+        return 0;
+    }
+
+    const uint64_t gain = ((static_cast<uint64_t>(leakSum) << 16) + signal / 2) / signal;
+    return static_cast<uint16_t>(std::min<uint64_t>(gain, cfg::CROSSTALK_MAX_GAIN));
+}
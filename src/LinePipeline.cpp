@@ -0,0 +1,18 @@
+#include <LinePipeline.hpp>
+
+using namespace micro;
+
+LinePipeline::LinePipeline(const bool whiteLevelCalibrationEnabled)
+    : linePosCalc_(whiteLevelCalibrationEnabled) {}
+
+void LinePipeline::run(const linePatternDomain_t domain, const size_t maxLines,
+                       const Measurements* const measurements, const meter_t* const distances,
+                       const m_per_sec_t* const speeds, const size_t numFrames,
+                       Lines* const OUT lines, LinePattern* const OUT patterns) {
+    for (size_t i = 0; i < numFrames; ++i) {
+        this->linePosCalc_.calculate(measurements[i], maxLines, this->linePositions_);
+        this->lineFilter_.update(this->linePositions_, maxLines, lines[i]);
+        this->linePatternCalc_.update(domain, lines[i], distances[i], sgn(speeds[i]));
+        patterns[i] = this->linePatternCalc_.pattern();
+    }
+}
@@ -1,183 +1,807 @@
 #include <LinePosCalculator.hpp>
-#include <numeric>
+#include <SensorKernels.hpp>
+#include <SortedWindow.hpp>
 
+#include <micro/container/vector.hpp>
 #include <micro/math/unit_utils.hpp>
 #include <micro/utils/algorithm.hpp>
 
 using namespace micro;
 
-LinePosCalculator::LinePosCalculator(const bool whiteLevelCalibrationEnabled)
-    : whiteLevelCalibrationEnabled_(whiteLevelCalibrationEnabled) {
-    this->whiteLevels_.fill(0);
+namespace {
+
+// the offset of a sensor is the 3rd smallest value of its window
+constexpr uint8_t OFFSET_FILTER_RANK = (2 * cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS + 1) / 3;
+
+// minimum index distance of consecutive line candidates
+constexpr int32_t MIN_CANDIDATE_DIST = 4;
+
+// Scan ranges are at least as large as the windows of the offset filter at the edges of the range,
+// which contain RADIUS + 1 values. The filter needs at least RANK + 1 values in each window.
+constexpr uint8_t MIN_SCAN_RANGE_SIZE = cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS + 1;
+static_assert(OFFSET_FILTER_RANK < MIN_SCAN_RANGE_SIZE, "Offset filter windows must contain RANK");
+
+constexpr float MAX_GROUP_INTENSITY = 1.0f / (1.0f + cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS);
+
+// A group intensity needs to exceed MIN_LINE_PROBABILITY * MAX_GROUP_INTENSITY to be detected as a
+// line. Intensities are never above the measurements scaled between the white levels and the
+// maximum measurement, so the frame contains no line if every scaled measurement is below it.
+// Q8 format, with a margin for the rounding of the calculation.
+constexpr uint32_t NO_LINE_MAX_SCALED_MEASUREMENT =
+    static_cast<uint32_t>(0.9f * cfg::MIN_LINE_PROBABILITY * MAX_GROUP_INTENSITY * 256);
+
+// exp(x) for the compile-time kernels: the series of exp(x / 16), squared 4 times
+constexpr double expSeries(const double x) {
+    double term   = 1.0;
+    double result = 1.0;
+    for (uint32_t n = 1; n < 20; ++n) {
+        term *= x / 16 / n;
+        result += term;
+    }
+    for (uint8_t i = 0; i < 4; ++i) {
+        result *= result;
+    }
+    return result;
 }
 
-LinePositions LinePosCalculator::calculate(const Measurements& measurements,
-                                           const size_t maxLines) {
-    LinePositions positions;
+constexpr uint8_t MATCHED_FILTER_SIZE = 2 * cfg::LINE_POS_CALC_MATCHED_FILTER_RADIUS + 1;
 
-    if (!this->whiteLevelCalibrationEnabled_ || this->whiteLevelCalibrationBuffer_.size() ==
-                                                    this->whiteLevelCalibrationBuffer_.capacity()) {
-        positions = this->runCalculation(measurements, maxLines);
-    } else {
-        this->runCalibration(measurements, maxLines);
+// Gaussian profile of a full intensity line, at the given offset from the center sensor
+constexpr std::array<float, MATCHED_FILTER_SIZE> lineProfile(const float offset) {
+    std::array<float, MATCHED_FILTER_SIZE> profile{};
+    for (uint8_t i = 0; i < MATCHED_FILTER_SIZE; ++i) {
+        const float z = (i - cfg::LINE_POS_CALC_MATCHED_FILTER_RADIUS - offset) /
+                        cfg::LINE_POS_CALC_MATCHED_FILTER_SIGMA;
+        profile[i] = static_cast<float>(expSeries(-0.5 * z * z));
     }
+    return profile;
+}
 
-    return positions;
+constexpr auto LINE_PROFILE = lineProfile(0.0f);
+
+// The line profile without its mean, normalized by the sum of the positive weights, so that the
+// response never exceeds the maximum scaled measurement.
+constexpr auto MATCHED_FILTER_KERNEL = [] {
+    float mean = 0.0f;
+    for (uint8_t i = 0; i < MATCHED_FILTER_SIZE; ++i) {
+        mean += LINE_PROFILE[i] / MATCHED_FILTER_SIZE;
+    }
+
+    std::array<float, MATCHED_FILTER_SIZE> kernel{};
+    float positiveSum = 0.0f;
+    for (uint8_t i = 0; i < MATCHED_FILTER_SIZE; ++i) {
+        kernel[i] = LINE_PROFILE[i] - mean;
+        positiveSum += std::max(kernel[i], 0.0f);
+    }
+    for (uint8_t i = 0; i < MATCHED_FILTER_SIZE; ++i) {
+        kernel[i] /= positiveSum;
+    }
+    return kernel;
+}();
+
+// Response of a full intensity line halfway between two sensors, the weakest response of a full
+// intensity line at the sensor nearest to it. Full intensity lines have a probability of 1 at any
+// sub-sensor position.
+constexpr float MAX_MATCHED_FILTER_RESPONSE = [] {
+    const auto profile = lineProfile(0.5f);
+    float response     = 0.0f;
+    for (uint8_t i = 0; i < MATCHED_FILTER_SIZE; ++i) {
+        response += profile[i] * MATCHED_FILTER_KERNEL[i];
+    }
+    return response;
+}();
+
+uint8_t scanRangeSize(const ScanRange& scanRange) {
+    return scanRange.second - scanRange.first + 1;
+}
+
+// bits of the sensors [first, last]
+uint64_t sensorMask(const uint8_t first, const uint8_t last) {
+    return (~uint64_t(0) << first) & (~uint64_t(0) >> (63 - last));
+}
+
+// extends each set bit of the mask to its neighbours within the radius
+uint64_t dilate(const uint64_t mask, const uint8_t radius) {
+    uint64_t result = mask;
+    for (uint8_t i = 1; i <= radius; ++i) {
+        result |= (mask << i) | (mask >> i);
+    }
+    return result;
+}
+
+constexpr uint8_t LINE_POS_RADIUS =
+    static_cast<uint8_t>(micro::ceil(cfg::LINE_POS_CALC_GROUP_RADIUS));
+
+// Calculates the offset of the weighted center of the group around the center sensor.
+// The radius is clamped to the sensors left of the center, each clamped radius is a separate
+// specialization with its own compile-time weights.
+template <typename intensity_t, uint8_t RADIUS>
+float centerOffset(const intensity_t* const intensities, const uint8_t centerIdx) {
+    using traits = IntensityTraits<intensity_t>;
+
+    static constexpr WeightCalculator CALC(RADIUS == LINE_POS_RADIUS
+                                               ? cfg::LINE_POS_CALC_GROUP_RADIUS
+                                               : static_cast<float>(RADIUS));
+    static constexpr auto WEIGHTS = [] {
+        std::array<typename traits::accumulator_t, 2 * RADIUS + 1> weights{};
+        for (int8_t subIdx = -CALC.radius; subIdx <= CALC.radius; ++subIdx) {
+            weights[subIdx + CALC.radius] = traits::weight(CALC.weight(subIdx));
+        }
+        return weights;
+    }();
+
+    if constexpr (RADIUS > 0) {
+        if (centerIdx < RADIUS) {
+            return centerOffset<intensity_t, RADIUS - 1>(intensities, centerIdx);
+        }
+    }
+    return kernel::centerOffset<RADIUS>(&intensities[centerIdx - RADIUS], WEIGHTS.data());
 }
 
-millimeter_t LinePosCalculator::optoIdxToLinePos(const float optoIdx) {
-    return micro::lerp(optoIdx, 0.0f, cfg::NUM_SENSORS - 1.0f, -cfg::OPTO_ARRAY_LENGTH / 2,
-                       cfg::OPTO_ARRAY_LENGTH / 2);
+// The local baseline of a sensor, calculated like its offset: the RANK-th smallest value of its
+// window in the scan range.
+template <typename intensity_t>
+intensity_t localBaseline(const intensity_t* const values, const uint8_t idx,
+                          const ScanRange& scanRange) {
+    static constexpr uint8_t RADIUS = cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS;
+
+    SortedWindow<intensity_t, 2 * RADIUS + 1> window;
+    const uint8_t last = std::min<uint8_t>(idx + RADIUS, scanRange.second);
+    for (uint8_t i = std::max<uint8_t>(idx, scanRange.first + RADIUS) - RADIUS; i <= last; ++i) {
+        window.insert(values[i]);
+    }
+    return window[OFFSET_FILTER_RANK];
+}
+
+// Finds the edges of the line around the peak sensor, where the profile falls below half of the
+// peak above the local baseline. The crossings are interpolated between the sensors, edges outside
+// the scan range are clamped to it. A peak that does not rise above the baseline has no half
+// maximum, its edges are half a sensor pitch away from it.
+template <typename intensity_t>
+std::pair<float, float> halfMaximumEdges(const intensity_t* const profile, const uint8_t peakIdx,
+                                         const ScanRange& scanRange) {
+    const float peak     = static_cast<float>(profile[peakIdx]);
+    const float baseline = static_cast<float>(localBaseline(profile, peakIdx, scanRange));
+
+    if (peak <= baseline) {
+        return {std::max(peakIdx - 0.5f, static_cast<float>(scanRange.first)),
+                std::min(peakIdx + 0.5f, static_cast<float>(scanRange.second))};
+    }
+
+    const float halfMaximum = 0.5f * (peak + baseline);
+
+    const auto crossing = [profile, halfMaximum](const uint8_t inside, const uint8_t outside) {
+        const float inner = static_cast<float>(profile[inside]);
+        const float outer = static_cast<float>(profile[outside]);
+        return inner == outer
+                   ? inside + 0.5f * (outside - inside)
+                   : inside + (outside - inside) * (inner - halfMaximum) / (inner - outer);
+    };
+
+    uint8_t left = peakIdx;
+    while (left > scanRange.first && profile[left - 1] >= halfMaximum) {
+        --left;
+    }
+
+    uint8_t right = peakIdx;
+    while (right < scanRange.second && profile[right + 1] >= halfMaximum) {
+        ++right;
+    }
+
+    return {left > scanRange.first ? crossing(left, left - 1) : left,
+            right < scanRange.second ? crossing(right, right + 1) : right};
 }
 
-float LinePosCalculator::linePosToOptoPos(const micro::millimeter_t linePos) {
-    return micro::lerp(linePos, -cfg::OPTO_ARRAY_LENGTH / 2, cfg::OPTO_ARRAY_LENGTH / 2, 0.0f,
-                       cfg::NUM_SENSORS - 1.0f);
+// Calls the function with the first and last sensors of each run of consecutive set bits.
+// A run that reaches the last bit of the mask has no clear bit after it to count to.
+template <typename F>
+void forEachSensorRun(uint64_t mask, const F& func) {
+    while (mask) {
+        const uint8_t first  = __builtin_ctzll(mask);
+        const uint64_t unset = ~(mask >> first);
+        const uint8_t last   = unset ? first + __builtin_ctzll(unset) - 1 : 63;
+        func(first, last);
+        mask &= ~sensorMask(first, last);
+    }
 }
 
-LinePositions LinePosCalculator::runCalculation(const Measurements& measurements,
-                                                const size_t maxLines) {
-    static constexpr float MAX_GROUP_INTENSITY =
-        1.0f / (1.0f + cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS);
+} // namespace
+
+template <typename intensity_t, typename sensor_array_t>
+BasicLinePosCalculator<intensity_t, sensor_array_t>::BasicLinePosCalculator(
+    const bool whiteLevelCalibrationEnabled, const bool whiteLevelAdaptationEnabled,
+    const linePosEstimator_t linePosEstimator, const lineSearch_t lineSearch)
+    : whiteLevelCalibrationEnabled_(whiteLevelCalibrationEnabled),
+      whiteLevelAdaptationEnabled_(whiteLevelAdaptationEnabled),
+      linePosEstimator_(linePosEstimator),
+      lineSearch_(lineSearch) {
+    this->restartWhiteLevelCalibration();
+}
 
+template <typename intensity_t, typename sensor_array_t>
+LinePositions BasicLinePosCalculator<intensity_t, sensor_array_t>::calculate(
+    const Measurements& measurements, const size_t maxLines, const ScanRange& scanRange) {
     LinePositions positions;
+    this->calculate(measurements, maxLines, positions, scanRange);
+    return positions;
+}
 
-    float intensities[cfg::NUM_SENSORS];
-    this->normalize(measurements, intensities);
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::calculate(
+    const Measurements& measurements, const size_t maxLines, LinePositions& OUT positions,
+    const ScanRange& scanRange) {
+    positions.clear();
 
-    if (std::accumulate(&intensities[0], &intensities[cfg::NUM_SENSORS], 0.0f) / cfg::NUM_SENSORS <
-        0.3f) {
-        auto groupIntensities = calculateGroupIntensities(intensities);
+    // the white levels are calibrated and adapted from the compensated measurements as well
+    const Measurements& compensated = this->removeCrosstalk(measurements, scanRange);
 
-        const float minGroupIntensity =
-            std::min_element(groupIntensities.begin(), groupIntensities.end())->intensity;
-        uint8_t lastInsertedIdx = 255;
+    if (!this->whiteLevelCalibrationEnabled_ || this->whiteLevelCalibrated_) {
+        this->runCalculation(compensated, maxLines, scanRange, positions);
+        if (this->whiteLevelAdaptationEnabled_ && this->frameClass_ != frameClass_t::SensorFault) {
+            this->adaptWhiteLevels(compensated, scanRange, positions);
+        }
+    } else if (scanRange == sensor_array_t::FULL_SCAN_RANGE) {
+        this->runCalibration(compensated, maxLines);
+    }
+}
 
-        while (positions.size() < maxLines && !groupIntensities.empty()) {
-            const auto candidate =
-                std::max_element(groupIntensities.begin(), groupIntensities.end());
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::calculate(
+    const Measurements* const measurements, const size_t numFrames, const size_t maxLines,
+    LinePositions* const OUT positions) {
+    for (size_t i = 0; i < numFrames; ++i) {
+        this->calculate(measurements[i], maxLines, positions[i]);
+    }
+}
 
-            if (micro::abs(static_cast<int32_t>(lastInsertedIdx) -
-                           static_cast<int32_t>(candidate->centerIdx)) >= 4) {
-                const millimeter_t linePos = calculateLinePos(intensities, candidate->centerIdx);
-                const float probability    = micro::lerp(candidate->intensity, minGroupIntensity,
-                                                         MAX_GROUP_INTENSITY, 0.0f, 1.0f);
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::setWhiteLevels(
+    const Measurements& whiteLevels) {
+    this->whiteLevels_ = whiteLevels;
+    this->applyWhiteLevels();
+    this->whiteLevelCalibrated_ = true;
+}
 
-                if (probability < cfg::MIN_LINE_PROBABILITY) {
-                    break;
-                }
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::setLineDetector(
+    const lineDetector_t lineDetector) {
+    if (lineDetector != this->lineDetector_) {
+        this->lineDetector_ = lineDetector;
+        this->cacheValid_   = false;
+    }
+}
 
-                if (std::find_if(positions.begin(), positions.end(), [linePos](const auto& pos) {
-                        return abs(pos.pos - linePos) <= cfg::MIN_LINE_DIST;
-                    }) == positions.end()) {
-                    positions.insert({linePos, probability});
-                }
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::setCrosstalk(const Crosstalk& crosstalk) {
+    this->crosstalk_  = crosstalk;
+    this->cacheValid_ = false;
+}
 
-                lastInsertedIdx = candidate->centerIdx;
-            }
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::setMaskedSensors(
+    const uint64_t maskedSensors) {
+    if (maskedSensors != this->maskedSensors_) {
+        this->maskedSensors_ = maskedSensors;
+        this->cacheValid_    = false;
+    }
+}
+
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::restartWhiteLevelCalibration() {
+    this->whiteLevels_.fill(0);
+    this->applyWhiteLevels();
+    this->whiteLevelCalibrated_           = false;
+    this->numWhiteLevelCalibrationFrames_ = 0;
+    this->whiteLevelSums_.fill(0);
+    this->whiteLevelSquareSums_.fill(0);
+}
 
-            groupIntensities.erase(candidate);
+template <typename intensity_t, typename sensor_array_t>
+millimeter_t BasicLinePosCalculator<intensity_t, sensor_array_t>::optoIdxToLinePos(
+    const float optoIdx) {
+    return micro::lerp(optoIdx, 0.0f, NUM_SENSORS - 1.0f, -sensor_array_t::LENGTH / 2,
+                       sensor_array_t::LENGTH / 2);
+}
+
+template <typename intensity_t, typename sensor_array_t>
+float BasicLinePosCalculator<intensity_t, sensor_array_t>::linePosToOptoPos(
+    const micro::millimeter_t linePos) {
+    return micro::lerp(linePos, -sensor_array_t::LENGTH / 2, sensor_array_t::LENGTH / 2, 0.0f,
+                       NUM_SENSORS - 1.0f);
+}
+
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::runCalculation(
+    const Measurements& measurements, const size_t maxLines, const ScanRange& scanRange,
+    LinePositions& OUT positions) {
+    static_assert(MIN_SCAN_RANGE_SIZE > 2 * GROUP_INTENSITY_RADIUS,
+                  "Scan ranges must contain at least one sensor group");
+
+    const uint8_t size = scanRangeSize(scanRange);
+    if (size < MIN_SCAN_RANGE_SIZE) {
+        this->frameClass_ = frameClass_t::NoLine;
+        return;
+    }
+
+    // only the scanned sensors are calculated, the rest of the cached arrays are not valid
+    if (!this->updateMeasurements(measurements, scanRange) && maxLines == this->cachedMaxLines_) {
+        positions = this->cachedPositions_;
+        return;
+    }
+
+    if (this->frameClass_ == frameClass_t::Normal) {
+        switch (this->lineDetector_) {
+        case lineDetector_t::GroupIntensity:
+            this->runGroupIntensityDetector(scanRange, maxLines, positions);
+            break;
+        case lineDetector_t::MatchedFilter:
+            this->runMatchedFilterDetector(scanRange, maxLines, positions);
+            break;
         }
     }
 
-    return positions;
+    this->cachedMaxLines_  = maxLines;
+    this->cachedPositions_ = positions;
 }
 
-void LinePosCalculator::runCalibration(const Measurements& measurements, const size_t maxLines) {
-    this->whiteLevelCalibrationBuffer_.push_back(measurements);
-    if (this->whiteLevelCalibrationBuffer_.size() ==
-        this->whiteLevelCalibrationBuffer_.capacity()) {
-        const LinePositions linePositions = this->runCalculation(measurements, maxLines);
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::runGroupIntensityDetector(
+    const ScanRange& scanRange, const size_t maxLines, LinePositions& OUT positions) {
+    // groups are only calculated where the whole group is inside the scan range
+    const uint64_t allGroups = sensorMask(scanRange.first + GROUP_INTENSITY_RADIUS,
+                                          scanRange.second - GROUP_INTENSITY_RADIUS);
 
-        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
-            float sum = 0.0f;
-            for (const Measurements& meas : this->whiteLevelCalibrationBuffer_) {
-                sum += meas[i];
-            }
-            this->whiteLevels_[i] = std::lround(sum / this->whiteLevelCalibrationBuffer_.size());
+    // the coarse pass: only the groups containing sensors that may be part of a line
+    const uint64_t groups = this->lineSearch_ == lineSearch_t::CoarseToFine
+                                ? dilate(this->lineSensors_, GROUP_INTENSITY_RADIUS) & allGroups
+                                : allGroups;
+
+    this->updateGroupIntensities(scanRange, groups);
+    this->findLines(scanRange, groups, maxLines, positions);
+
+    if (positions.empty() && groups != allGroups) {
+        this->updateGroupIntensities(scanRange, allGroups);
+        this->findLines(scanRange, allGroups, maxLines, positions);
+    }
+}
+
+// The scaled measurements of the scan range are correlated with the matched filter kernel.
+// The edge values are repeated outside the scan range, so that the edges have no response.
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::runMatchedFilterDetector(
+    const ScanRange& scanRange, const size_t maxLines, LinePositions& OUT positions) {
+    static constexpr uint8_t RADIUS = MATCHED_FILTER_RADIUS;
+    static constexpr auto WEIGHTS   = [] {
+        std::array<accumulator_t, 2 * RADIUS + 1> weights{};
+        for (uint8_t i = 0; i < 2 * RADIUS + 1; ++i) {
+            weights[i] = traits::averageWeight(MATCHED_FILTER_KERNEL[i], 1.0f);
+        }
+        return weights;
+    }();
+
+    const uint8_t size = scanRangeSize(scanRange);
+    intensity_t* const padded = &this->paddedScaled_[scanRange.first];
+    std::fill_n(padded, RADIUS, this->scaled_[scanRange.first]);
+    std::copy_n(&this->scaled_[scanRange.first], size, padded + RADIUS);
+    std::fill_n(padded + RADIUS + size, RADIUS, this->scaled_[scanRange.second]);
+
+    kernel::weightedAverage<RADIUS>(padded, WEIGHTS.data(), &this->responses_[scanRange.first],
+                                    size + 2 * RADIUS);
+
+    // responses indexed by the sensors, the positions need both neighbours of the candidates
+    const intensity_t* const responses = &this->responses_[RADIUS];
+    const uint64_t candidates = sensorMask(scanRange.first + LINE_POS_RADIUS,
+                                           scanRange.second - LINE_POS_RADIUS);
+
+    this->selectLines(scanRange, responses, responses, candidates, 0.0f,
+                      MAX_MATCHED_FILTER_RESPONSE, maxLines, positions);
+}
+
+// The LEDs outside the scan range are not lit by SensorHandler, so the sensors outside the scan
+// range are treated as having no crosstalk.
+template <typename intensity_t, typename sensor_array_t>
+auto BasicLinePosCalculator<intensity_t, sensor_array_t>::removeCrosstalk(
+    const Measurements& measurements, const ScanRange& scanRange) -> const Measurements& {
+    if (!this->crosstalk_.stride) {
+        return measurements;
+    }
+
+    this->compensated_ = measurements;
+    kernel::removeCrosstalk(&measurements[scanRange.first],
+                            &this->crosstalk_.dark[scanRange.first],
+                            &this->crosstalk_.left[scanRange.first],
+                            &this->crosstalk_.right[scanRange.first], this->crosstalk_.stride,
+                            &this->compensated_[scanRange.first], scanRangeSize(scanRange));
+    return this->compensated_;
+}
+
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::runCalibration(
+    const Measurements& measurements, const size_t maxLines) {
+    for (uint8_t i = 0; i < NUM_SENSORS; ++i) {
+        this->whiteLevelSums_[i] += measurements[i];
+        this->whiteLevelSquareSums_[i] += measurements[i] * measurements[i];
+    }
+    ++this->numWhiteLevelCalibrationFrames_;
+
+    if (this->numWhiteLevelCalibrationFrames_ >= cfg::WHITE_LEVEL_CALIB_MIN_FRAMES &&
+        (this->numWhiteLevelCalibrationFrames_ == cfg::WHITE_LEVEL_CALIB_MAX_FRAMES ||
+         this->isWhiteLevelCalibrationConverged())) {
+        LinePositions linePositions;
+        this->runCalculation(measurements, maxLines, sensor_array_t::FULL_SCAN_RANGE,
+                             linePositions);
+
+        const uint32_t n = this->numWhiteLevelCalibrationFrames_;
+        for (uint8_t i = 0; i < NUM_SENSORS; ++i) {
+            this->whiteLevels_[i] = (this->whiteLevelSums_[i] + n / 2) / n;
         }
 
         this->updateInvalidWhiteLevels(linePositions);
+        this->applyWhiteLevels();
+        this->whiteLevelCalibrated_ = true;
     }
 }
 
-void LinePosCalculator::updateInvalidWhiteLevels(const LinePositions& linePositions) {
+// The calibration has converged when the standard error of the mean is below half a level
+// for every sensor: 4 * variance / n < 1, multiplied by n^2 to keep it in integers.
+template <typename intensity_t, typename sensor_array_t>
+bool BasicLinePosCalculator<intensity_t, sensor_array_t>::isWhiteLevelCalibrationConverged() const {
+    const uint64_t n = this->numWhiteLevelCalibrationFrames_;
+
+    for (uint8_t i = 0; i < NUM_SENSORS; ++i) {
+        const uint64_t sum       = this->whiteLevelSums_[i];
+        const uint64_t squareSum = this->whiteLevelSquareSums_[i];
+        if (4 * (n * squareSum - sum * sum) >= n * n * n) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::updateInvalidWhiteLevels(
+    const LinePositions& linePositions) {
     Measurements sortedWhiteLevels;
     std::copy(this->whiteLevels_.begin(), this->whiteLevels_.end(), sortedWhiteLevels.begin());
     std::sort(sortedWhiteLevels.begin(), sortedWhiteLevels.end());
-    const uint8_t whiteLevelMedian = sortedWhiteLevels[cfg::NUM_SENSORS / 2];
+    const uint8_t whiteLevelMedian = sortedWhiteLevels[NUM_SENSORS / 2];
 
     for (const LinePosition& linePos : linePositions) {
         const uint8_t sensorIdx = std::lround(linePosToOptoPos(linePos.pos));
 
-        const std::pair<Measurements::iterator, Measurements::iterator> range = {
+        const std::pair<typename Measurements::iterator, typename Measurements::iterator> range = {
             std::next(this->whiteLevels_.begin(),
                       max<uint8_t>(sensorIdx, cfg::WHITE_LEVEL_LINE_GROUP_RADIUS) -
                           cfg::WHITE_LEVEL_LINE_GROUP_RADIUS),
             std::next(this->whiteLevels_.begin(),
                       min<uint8_t>(sensorIdx + cfg::WHITE_LEVEL_LINE_GROUP_RADIUS + 1,
-                                   cfg::NUM_SENSORS))};
+                                   NUM_SENSORS))};
 
-        for (Measurements::iterator it = range.first; it != range.second; ++it) {
+        for (typename Measurements::iterator it = range.first; it != range.second; ++it) {
             *it = whiteLevelMedian;
         }
     }
 }
 
-void LinePosCalculator::normalize(const Measurements& measurements, float* const OUT result) {
-    float scaled[cfg::NUM_SENSORS];
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::applyWhiteLevels() {
+    for (uint8_t i = 0; i < NUM_SENSORS; ++i) {
+        this->gains_[i]               = traits::gain(this->whiteLevels_[i]);
+        this->whiteLevelEstimates_[i] = this->whiteLevels_[i] << 8;
+    }
+    this->cacheValid_ = false;
+}
 
-    // removes sensor-specific offset
-    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
-        scaled[i] = micro::lerp<uint8_t>(measurements[i], this->whiteLevels_[i], 255, 0.0f, 1.0f);
+// Updates the white level estimates of the sensors that are not near any line with an exponentially
+// weighted moving average. Measurements much higher than the white level are ignored, as they are
+// probably caused by undetected lines. Gains are only recalculated when a white level changes.
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::adaptWhiteLevels(
+    const Measurements& measurements, const ScanRange& scanRange,
+    const LinePositions& linePositions) {
+    uint64_t lineSensors = 0;
+    for (const LinePosition& linePos : linePositions) {
+        const int32_t sensorIdx = std::lround(linePosToOptoPos(linePos.pos));
+        for (int32_t i = sensorIdx - cfg::WHITE_LEVEL_LINE_GROUP_RADIUS;
+             i <= sensorIdx + cfg::WHITE_LEVEL_LINE_GROUP_RADIUS; ++i) {
+            if (i >= 0 && i < NUM_SENSORS) {
+                lineSensors |= uint64_t(1) << i;
+            }
+        }
     }
 
-    // removes dynamic light-related offset, that applies to the adjacent sensors
-    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
-        const uint8_t startIdx = max<uint8_t>(i, cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS) -
-                                 cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS;
-        const uint8_t endIdx =
-            min<uint8_t>(i + cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS + 1, cfg::NUM_SENSORS);
+    for (uint8_t i = scanRange.first; i <= scanRange.second; ++i) {
+        if ((lineSensors & (uint64_t(1) << i)) ||
+            measurements[i] > this->whiteLevels_[i] + cfg::WHITE_LEVEL_ADAPTATION_MAX_INCR) {
+            continue;
+        }
 
-        std::array<float, 2 * cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS + 1> group;
-        std::copy(&scaled[startIdx], &scaled[endIdx], group.begin());
-        std::sort(group.begin(), std::next(group.begin(), endIdx - startIdx));
+        const int32_t diff = (measurements[i] << 8) - this->whiteLevelEstimates_[i];
+        this->whiteLevelEstimates_[i] += diff >> cfg::WHITE_LEVEL_ADAPTATION_SHIFT;
 
-        result[i] = micro::lerp(scaled[i], group[group.size() / 3], 1.0f, 0.0f, 1.0f);
+        const uint8_t whiteLevel = (this->whiteLevelEstimates_[i] + (1 << 7)) >> 8;
+        if (whiteLevel != this->whiteLevels_[i]) {
+            this->whiteLevels_[i] = whiteLevel;
+            this->gains_[i]       = traits::gain(whiteLevel);
+            this->staleSensors_ |= uint64_t(1) << i;
+        }
     }
 }
 
-LinePosCalculator::groupIntensities_t
-LinePosCalculator::calculateGroupIntensities(const float* const intensities) {
-    static constexpr WeightCalculator CALC(cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS);
+// Only the sensors whose measurements or white levels changed are rescaled. Their changes propagate
+// to the offsets and intensities within the offset filter radius, and to the group intensities
+// within the group radius, which are recalculated when they are needed by the search.
+// Returns false if no sensor changed, so the results of the previous frame are still valid.
+template <typename intensity_t, typename sensor_array_t>
+bool BasicLinePosCalculator<intensity_t, sensor_array_t>::updateMeasurements(
+    const Measurements& measurements, const ScanRange& scanRange) {
+    const bool fullUpdate         = !this->cacheValid_ || scanRange != this->cachedScanRange_;
+    const uint64_t scannedSensors = sensorMask(scanRange.first, scanRange.second);
+
+    uint64_t changedSensors = this->staleSensors_ & scannedSensors;
+    bool saturated          = true;
+    bool notRead            = true;
+
+    this->lineSensors_ = 0;
+
+    for (uint8_t i = scanRange.first; i <= scanRange.second; ++i) {
+        if (fullUpdate || micro::abs(measurements[i] - this->cachedMeasurements_[i]) >
+                              cfg::LINE_POS_CALC_MEASUREMENT_DEADBAND) {
+            this->cachedMeasurements_[i] = measurements[i];
+            changedSensors |= uint64_t(1) << i;
+        }
+
+        if (this->maskedSensors_ & (uint64_t(1) << i)) {
+            continue;
+        }
 
-    groupIntensities_t groupIntensities;
-    for (uint8_t groupIdx = CALC.radius; groupIdx < cfg::NUM_SENSORS - CALC.radius; ++groupIdx) {
-        float groupIntensity = 0.0f;
+        // classifies the frame from the raw measurements
+        const int32_t meas       = this->cachedMeasurements_[i];
+        const int32_t whiteLevel = this->whiteLevels_[i];
+        if ((meas - whiteLevel) * 256 >=
+            static_cast<int32_t>(NO_LINE_MAX_SCALED_MEASUREMENT) * (255 - whiteLevel)) {
+            this->lineSensors_ |= uint64_t(1) << i;
+        }
+        saturated &= meas == 255;
+        notRead &= meas == 0;
+    }
+
+    this->frameClass_ = notRead               ? frameClass_t::SensorFault
+                        : saturated           ? frameClass_t::Saturated
+                        : !this->lineSensors_ ? frameClass_t::NoLine
+                                              : frameClass_t::Normal;
+
+    if (fullUpdate) {
+        this->staleIntensities_ = 0;
+        this->staleGroups_      = 0;
+    }
+
+    this->cacheValid_      = true;
+    this->cachedScanRange_ = scanRange;
+    this->staleSensors_    = 0;
+
+    // no line can be found, the changed sensors are recalculated in the next normal frame
+    if (this->frameClass_ != frameClass_t::Normal) {
+        this->staleSensors_ = changedSensors;
+        return changedSensors != 0;
+    }
+
+    // removes sensor-specific offset
+    forEachSensorRun(changedSensors, [this](const uint8_t first, const uint8_t last) {
+        kernel::scale(&this->cachedMeasurements_[first], &this->whiteLevels_[first],
+                      &this->gains_[first], &this->scaled_[first], last - first + 1);
+    });
+
+    changedSensors |= this->interpolateMaskedSensors(scanRange, changedSensors);
+
+    this->staleIntensities_ |=
+        dilate(changedSensors, cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS) & scannedSensors;
+
+    return changedSensors != 0;
+}
+
+// Masked sensors are interpolated linearly between their nearest healthy neighbours in the scan
+// range. Runs are only recalculated when they or their neighbours changed, the recalculated
+// sensors are returned.
+template <typename intensity_t, typename sensor_array_t>
+uint64_t BasicLinePosCalculator<intensity_t, sensor_array_t>::interpolateMaskedSensors(
+    const ScanRange& scanRange, const uint64_t changedSensors) {
+    uint64_t interpolated = 0;
+
+    const uint64_t maskedSensors =
+        this->maskedSensors_ & sensorMask(scanRange.first, scanRange.second);
+
+    forEachSensorRun(maskedSensors, [&](const uint8_t first, const uint8_t last) {
+        const bool hasLeft  = first > scanRange.first;
+        const bool hasRight = last < scanRange.second;
+        const uint64_t run  = sensorMask(first, last);
+        const uint64_t neighbours =
+            (hasLeft ? uint64_t(1) << (first - 1) : 0) | (hasRight ? uint64_t(1) << (last + 1) : 0);
+
+        if (!(changedSensors & (run | neighbours))) {
+            return;
+        }
+
+        const accumulator_t left =
+            hasLeft ? this->scaled_[first - 1] : hasRight ? this->scaled_[last + 1] : 0;
+        const accumulator_t right = hasRight ? this->scaled_[last + 1] : left;
+        const int32_t n           = last - first + 2;
+        for (uint8_t i = first; i <= last; ++i) {
+            this->scaled_[i] =
+                static_cast<intensity_t>((left * (last + 1 - i) + right * (i - first + 1)) / n);
+        }
+        interpolated |= run;
+    });
+
+    return interpolated;
+}
+
+// Recalculates the stale intensities and group intensities needed by the groups.
+// The intensities are needed within the group radius, and for the line positions.
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::updateGroupIntensities(
+    const ScanRange& scanRange, const uint64_t groups) {
+    static constexpr uint8_t OFFSET_FILTER_RADIUS = cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS;
+    static constexpr WeightCalculator CALC(cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS);
+    static constexpr auto WEIGHTS = [] {
+        std::array<accumulator_t, 2 * CALC.radius + 1> weights{};
         for (int8_t subIdx = -CALC.radius; subIdx <= CALC.radius; ++subIdx) {
-            groupIntensity += CALC.weight(subIdx) * intensities[groupIdx + subIdx];
+            weights[subIdx + CALC.radius] =
+                traits::averageWeight(CALC.weight(subIdx), CALC.sumWeight);
         }
+        return weights;
+    }();
+
+    const uint64_t neededSensors =
+        dilate(groups, std::max(GROUP_INTENSITY_RADIUS, LINE_POS_RADIUS)) &
+        sensorMask(scanRange.first, scanRange.second);
+    const uint64_t changedOffsets = this->staleIntensities_ & neededSensors;
 
-        groupIntensities.push_back({groupIdx, groupIntensity / CALC.sumWeight});
+    // removes dynamic light-related offset, that applies to the adjacent sensors
+    forEachSensorRun(changedOffsets, [this, &scanRange](const uint8_t first, const uint8_t last) {
+        slidingOrderStatistic<OFFSET_FILTER_RADIUS, OFFSET_FILTER_RANK>(
+            &this->scaled_[scanRange.first], scanRangeSize(scanRange), first - scanRange.first,
+            last + 1 - scanRange.first, &this->offsets_[scanRange.first]);
+
+        kernel::removeOffset(&this->scaled_[first], &this->offsets_[first],
+                             &this->intensities_[first], last - first + 1);
+    });
+
+    this->staleIntensities_ &= ~neededSensors;
+    this->staleGroups_ |= dilate(changedOffsets, CALC.radius) &
+                          sensorMask(scanRange.first + CALC.radius, scanRange.second - CALC.radius);
+
+    forEachSensorRun(this->staleGroups_ & groups, [this](const uint8_t first, const uint8_t last) {
+        kernel::weightedAverage<CALC.radius>(&this->intensities_[first - CALC.radius],
+                                             WEIGHTS.data(),
+                                             &this->groupIntensities_[first - CALC.radius],
+                                             last - first + 1 + 2 * CALC.radius);
+    });
+
+    this->staleGroups_ &= ~groups;
+}
+
+// Searches the lines in the groups, the candidates are processed in the order of their ranks,
+// starting from the strongest group.
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::findLines(
+    const ScanRange& scanRange, const uint64_t groups, const size_t maxLines,
+    LinePositions& OUT positions) const {
+    static constexpr intensity_t MAX_MEAN_INTENSITY = traits::fromFloat(0.3f);
+    static constexpr intensity_t MAX_UNSEARCHED_INTENSITY =
+        traits::fromFloat(NO_LINE_MAX_SCALED_MEASUREMENT / 256.0f);
+
+    // The intensities outside the groups are below the line threshold, they are counted at the
+    // threshold, so that a partial search does not underestimate the mean intensity.
+    const uint64_t searchedSensors =
+        dilate(groups, GROUP_INTENSITY_RADIUS) & sensorMask(scanRange.first, scanRange.second);
+    const int32_t numUnsearched = scanRangeSize(scanRange) - __builtin_popcountll(searchedSensors);
+    accumulator_t intensitySum =
+        numUnsearched * static_cast<accumulator_t>(MAX_UNSEARCHED_INTENSITY);
+    forEachSensorRun(searchedSensors,
+                     [this, &intensitySum](const uint8_t first, const uint8_t last) {
+                         intensitySum += kernel::sum(&this->intensities_[first], last - first + 1);
+                     });
+
+    if (intensitySum / scanRangeSize(scanRange) >= MAX_MEAN_INTENSITY) {
+        return;
     }
-    return groupIntensities;
+
+    // The weakest searched group of a partial search is not weaker than the weakest group of the
+    // scan range, so the probabilities are never higher than in a full search.
+    intensity_t minGroupIntensity = std::numeric_limits<intensity_t>::max();
+    forEachSensorRun(groups, [this, &minGroupIntensity](const uint8_t first, const uint8_t last) {
+        minGroupIntensity =
+            std::min(minGroupIntensity, *std::min_element(&this->groupIntensities_[first],
+                                                          &this->groupIntensities_[last + 1]));
+    });
+
+    this->selectLines(scanRange, this->groupIntensities_.data(), this->intensities_.data(), groups,
+                      traits::toFloat(minGroupIntensity), MAX_GROUP_INTENSITY, maxLines, positions);
 }
 
-millimeter_t LinePosCalculator::calculateLinePos(const float* const intensities,
-                                                 const uint8_t centerIdx) {
-    const WeightCalculator calc(cfg::LINE_POS_CALC_GROUP_RADIUS, centerIdx);
+// The candidates are processed in the order of their ranks, starting from the strongest group,
+// until maxLines lines have been found. Groups closer than MIN_CANDIDATE_DIST sensors to the
+// previous candidate are skipped. The groups above the minimum probability are sorted by their
+// ranks in a single pass, so there is no limit on the number of candidates processed in a frame.
+// The probabilities are interpolated between the minimum and maximum ranks, the positions are
+// calculated from the intensities.
+// The edges are calculated from the scaled measurements, that are up-to-date in the whole scan
+// range, and are not widened by the group or matched filter kernels. The ambient offset is
+// removed by measuring the half maximum above the local baseline.
+template <typename intensity_t, typename sensor_array_t>
+void BasicLinePosCalculator<intensity_t, sensor_array_t>::selectLines(
+    const ScanRange& scanRange, const intensity_t* const ranks,
+    const intensity_t* const intensities, const uint64_t candidates, const float minRank,
+    const float maxRank, const size_t maxLines, LinePositions& OUT positions) const {
+    micro::vector<groupIntensity_t, NUM_SENSORS> ranked;
+
+    const auto probability = [minRank, maxRank](const intensity_t rank) {
+        return micro::lerp(traits::toFloat(rank), minRank, maxRank, 0.0f, 1.0f);
+    };
+
+    forEachSensorRun(candidates, [ranks, &probability, &ranked](const uint8_t first,
+                                                               const uint8_t last) {
+        for (uint8_t i = first; i <= last; ++i) {
+            const groupIntensity_t group{i, ranks[i]};
+            if (probability(group.intensity) >= cfg::MIN_LINE_PROBABILITY) {
+                auto pos = ranked.end();
+                while (pos != ranked.begin() && group.ranksBefore(*std::prev(pos))) {
+                    --pos;
+                }
+                ranked.insert(pos, group);
+            }
+        }
+    });
 
-    float sum  = 0;
-    float sumW = 0;
+    const groupIntensity_t* prev = nullptr;
+    for (const groupIntensity_t& candidate : ranked) {
+        if (positions.size() == maxLines) {
+            break;
+        }
 
-    for (int8_t subIdx = -calc.radius; subIdx <= calc.radius; ++subIdx) {
-        const uint8_t idx = centerIdx + subIdx;
-        const float m     = intensities[idx];
-        const float w     = calc.weight(subIdx);
+        if (prev && micro::abs(static_cast<int32_t>(candidate.centerIdx) -
+                               static_cast<int32_t>(prev->centerIdx)) < MIN_CANDIDATE_DIST) {
+            continue;
+        }
+        prev = &candidate;
+
+        const millimeter_t linePos = calculateLinePos(intensities, candidate.centerIdx);
+        if (std::find_if(positions.begin(), positions.end(), [linePos](const auto& pos) {
+                return abs(pos.pos - linePos) <= cfg::MIN_LINE_DIST;
+            }) == positions.end()) {
+            const auto edges =
+                halfMaximumEdges(this->scaled_.data(), candidate.centerIdx, scanRange);
+            positions.insert({linePos, probability(candidate.intensity),
+                              optoIdxToLinePos(edges.first), optoIdxToLinePos(edges.second)});
+        }
+    }
+}
 
-        sum += m * w;
-        sumW += m * w * idx;
+template <typename intensity_t, typename sensor_array_t>
+millimeter_t BasicLinePosCalculator<intensity_t, sensor_array_t>::calculateLinePos(
+    const intensity_t* const intensities, const uint8_t centerIdx) const {
+    float offset = 0.0f;
+
+    // the fitted estimators need both neighbours of the peak
+    const bool fitted =
+        centerIdx > 0 && centerIdx + 1 < NUM_SENSORS &&
+        ((this->linePosEstimator_ == linePosEstimator_t::Gaussian &&
+          kernel::gaussianOffset(&intensities[centerIdx - 1], offset)) ||
+         (this->linePosEstimator_ != linePosEstimator_t::Centroid &&
+          kernel::parabolaOffset(&intensities[centerIdx - 1], offset)));
+
+    if (!fitted) {
+        offset = centerOffset<intensity_t, LINE_POS_RADIUS>(intensities, centerIdx);
     }
 
-    return optoIdxToLinePos(sumW / sum);
+    return optoIdxToLinePos(centerIdx + offset);
 }
+
+template class BasicLinePosCalculator<float, PanelSensorArray>;
+template class BasicLinePosCalculator<q15_t, PanelSensorArray>;
+template class BasicLinePosCalculator<float, SensorArray32>;
+template class BasicLinePosCalculator<q15_t, SensorArray32>;
+template class BasicLinePosCalculator<float, SensorArray64>;
+template class BasicLinePosCalculator<q15_t, SensorArray64>;
@@ -1,4 +1,5 @@
 #include <SensorHandler.hpp>
+#include <array>
 #include <cfg_sensor.hpp>
 #include <utility>
 
@@ -8,7 +9,17 @@
 using namespace micro;
 
 /**
- * Sensor Lighting Mode Configuration
+ * Sensor Lighting Mode Configuration (cfg::NUM_PARALLEL_SENSORS)
+ *
+ * 12 sensor mode (not validated on the panel yet):
+ * - Lights up 12 sensors at once (every 4th sensor across the 48-sensor array)
+ * - Creates 4 groups of 12 sensors each:
+ *   Group 0: sensors 0, 4, 8, ..., 44
+ *   Group 1: sensors 1, 5, 9, ..., 45
+ *   ...and so on
+ * - Requires 4 iterations to read all 48 sensors, each ADC reads 2 channels in an iteration
+ * - The crosstalk of the adjacent lit sensors is removed by the line position calculation,
+ *   it is measured at startup (see CrosstalkCalibration)
  *
  * 6 sensor mode:
  * - Lights up 6 sensors at once (every 8th sensor across the 48-sensor array)
@@ -26,40 +37,31 @@ using namespace micro;
  *   ...and so on
  * - Requires 16 iterations to read all 48 sensors
  */
-#define NUM_PARALLEL_SENSORS 6
-
-constexpr uint8_t NUM_ITERATIONS = cfg::NUM_SENSORS / NUM_PARALLEL_SENSORS;
+constexpr uint8_t NUM_ITERATIONS = cfg::NUM_SENSORS / cfg::NUM_PARALLEL_SENSORS;
+constexpr uint8_t NUM_SELECTORS  = cfg::NUM_SENSORS / 8;
 
 namespace {
-#if NUM_PARALLEL_SENSORS == 6
-
-// Optimized for highest minimum distance between two measurements: 3
-constexpr uint8_t SENSOR_GROUPS[NUM_ITERATIONS] = {0, 3, 6, 1, 4, 7, 2, 5};
-
-constexpr uint8_t SENSOR_SELECTORS[NUM_ITERATIONS][cfg::NUM_SENSORS / 8] = {
-    {1, 1, 1, 1, 1, 1},
-    {2, 2, 2, 2, 2, 2},
-    {4, 4, 4, 4, 4, 4},
-    {8, 8, 8, 8, 8, 8},
-    {16, 16, 16, 16, 16, 16},
-    {32, 32, 32, 32, 32, 32},
-    {64, 64, 64, 64, 64, 64},
-    {128, 128, 128, 128, 128, 128}
-};
 
-#elif NUM_PARALLEL_SENSORS == 3
+static_assert(NUM_ITERATIONS == 4 || NUM_ITERATIONS == 8 || NUM_ITERATIONS == 16,
+              "Unsupported number of parallel sensors");
 
-// Optimized for highest minimum distance between two measurements: 5
-constexpr uint8_t SENSOR_GROUPS[NUM_ITERATIONS] = {0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11};
-
-constexpr uint8_t SENSOR_SELECTORS[NUM_ITERATIONS][cfg::NUM_SENSORS / 8] = {
-    {0, 1, 0, 1, 0, 1},    {0, 2, 0, 2, 0, 2},    {0, 4, 0, 4, 0, 4},    {0, 8, 0, 8, 0, 8},
-    {0, 16, 0, 16, 0, 16}, {0, 32, 0, 32, 0, 32}, {0, 64, 0, 64, 0, 64}, {0, 128, 0, 128, 0, 128},
-    {1, 0, 1, 0, 1, 0},    {2, 0, 2, 0, 2, 0},    {4, 0, 4, 0, 4, 0},    {8, 0, 8, 0, 8, 0},
-    {16, 0, 16, 0, 16, 0}, {32, 0, 32, 0, 32, 0}, {64, 0, 64, 0, 64, 0}, {128, 0, 128, 0, 128, 0}};
+// Optimized for highest minimum distance between two measurements: 1, 3 and 5 in 12, 6 and 3
+// sensor modes
+constexpr uint8_t GROUP_ORDER_STEP = NUM_ITERATIONS == 4 ? 1 : NUM_ITERATIONS == 8 ? 3 : 5;
 
+constexpr auto SENSOR_GROUPS = [] {
+    std::array<uint8_t, NUM_ITERATIONS> groups{};
+    for (uint8_t i = 0; i < NUM_ITERATIONS; ++i) {
+        groups[i] = i * GROUP_ORDER_STEP % NUM_ITERATIONS;
+    }
+    return groups;
+}();
 
-#endif // NUM_PARALLEL_SENSORS
+// The first selector is shifted to the last LED driver of the chain, each driver selects the LEDs
+// of the 8 sensors of an ADC.
+constexpr uint8_t selectorIdx(const uint8_t sensorIdx) {
+    return NUM_SELECTORS - 1 - sensorIdx / 8;
+}
 
 } // namespace
 
@@ -87,28 +89,54 @@ void SensorHandler::readSensors(Measurements& OUT measurements,
                                 const std::pair<uint8_t, uint8_t>& scanRange) {
     for (uint8_t i = 0; i < NUM_ITERATIONS; ++i) {
         const uint8_t groupIdx = SENSOR_GROUPS[i];
-        this->exchangeData(SENSOR_SELECTORS[groupIdx], nullptr, cfg::NUM_SENSORS / 8);
 
-        gpio_write(this->LE_opto_, gpioPinState_t::SET);
-        gpio_write(this->LE_opto_, gpioPinState_t::RESET);
-        gpio_write(this->OE_opto_, gpioPinState_t::RESET);
+        // only the LEDs of the scan range are lit, so the sensors outside it cause no crosstalk
+        uint8_t selectors[NUM_SELECTORS] = {};
+        for (uint8_t absPos = groupIdx; absPos < cfg::NUM_SENSORS; absPos += NUM_ITERATIONS) {
+            if (micro::isBtw(absPos, scanRange.first, scanRange.second)) {
+                selectors[selectorIdx(absPos)] |= 1 << (absPos % 8);
+            }
+        }
+        this->lightUp(selectors);
+
+        for (uint8_t absPos = groupIdx; absPos < cfg::NUM_SENSORS; absPos += NUM_ITERATIONS) {
+            if (micro::isBtw(absPos, scanRange.first, scanRange.second)) {
+                measurements[absPos] = this->readSensor(absPos);
+            }
+        }
+
+        gpio_write(this->OE_opto_, gpioPinState_t::SET);
+    }
+}
 
-        for (volatile uint32_t t = 0; t < 800; ++t) {
-        } // waits between the LED light-up and the ADC read
+// The LEDs are lit one at a time, the crosstalk is measured by the sensors that are lit in
+// parallel with the lit one.
+void SensorHandler::readCrosstalk(CrosstalkMeasurements& OUT measurements) {
+    uint8_t selectors[NUM_SELECTORS] = {};
 
-        for (uint8_t adcIdx = groupIdx / 8; adcIdx < cfg::NUM_SENSORS / 8; adcIdx += NUM_ITERATIONS / 8) {
-            const uint8_t absPos = (adcIdx * 8) + (groupIdx % 8);
+    this->lightUp(selectors);
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        measurements.dark[i] = this->readSensor(i);
+    }
+    gpio_write(this->OE_opto_, gpioPinState_t::SET);
 
-            if (micro::isBtw(absPos, scanRange.first, scanRange.second)) {
-                const gpio_t& adcEnPin = this->adcEnPins_[adcIdx];
+    measurements.litLeft  = measurements.dark;
+    measurements.litRight = measurements.dark;
 
-                gpio_write(adcEnPin, gpioPinState_t::RESET);
-                measurements[absPos] = this->readAdc(groupIdx);
-                gpio_write(adcEnPin, gpioPinState_t::SET);
-            }
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        selectors[selectorIdx(i)] = 1 << (i % 8);
+        this->lightUp(selectors);
+
+        measurements.lit[i] = this->readSensor(i);
+        if (i >= NUM_ITERATIONS) {
+            measurements.litRight[i - NUM_ITERATIONS] = this->readSensor(i - NUM_ITERATIONS);
+        }
+        if (i + NUM_ITERATIONS < cfg::NUM_SENSORS) {
+            measurements.litLeft[i + NUM_ITERATIONS] = this->readSensor(i + NUM_ITERATIONS);
         }
 
         gpio_write(this->OE_opto_, gpioPinState_t::SET);
+        selectors[selectorIdx(i)] = 0;
     }
 }
 
@@ -133,6 +161,26 @@ void SensorHandler::onTxFinished() {
     this->semaphore_.give();
 }
 
+void SensorHandler::lightUp(const uint8_t* const selectors) {
+    this->exchangeData(selectors, nullptr, NUM_SELECTORS);
+
+    gpio_write(this->LE_opto_, gpioPinState_t::SET);
+    gpio_write(this->LE_opto_, gpioPinState_t::RESET);
+    gpio_write(this->OE_opto_, gpioPinState_t::RESET);
+
+    for (volatile uint32_t t = 0; t < 800; ++t) {
+    } // waits between the LED light-up and the ADC read
+}
+
+uint8_t SensorHandler::readSensor(const uint8_t sensorIdx) {
+    const gpio_t& adcEnPin = this->adcEnPins_[sensorIdx / 8];
+
+    gpio_write(adcEnPin, gpioPinState_t::RESET);
+    const uint8_t measurement = this->readAdc(sensorIdx % 8);
+    gpio_write(adcEnPin, gpioPinState_t::SET);
+    return measurement;
+}
+
 uint8_t SensorHandler::readAdc(const uint8_t channel) {
     uint8_t adcBuffer[3] = {0, 0, 0};
 
@@ -0,0 +1,98 @@
+#include <SensorHealthMonitor.hpp>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+constexpr uint8_t STUCK_HIGH_MIN_LEVEL = 128;
+
+uint64_t scannedSensors(const ScanRange& scanRange) {
+    const uint8_t size = scanRange.second - scanRange.first + 1;
+    return (size >= 64 ? ~0ull : (1ull << size) - 1) << scanRange.first;
+}
+
+} // namespace
+
+SensorHealthMonitor::SensorHealthMonitor() {
+    this->health_.fill(sensorHealth_t::Ok);
+    this->restartWindow();
+}
+
+void SensorHealthMonitor::update(const Measurements& measurements, const ScanRange& scanRange) {
+    const uint64_t scanned = scannedSensors(scanRange);
+
+    // frame-to-frame changes, sensors outside the panel are handled as if they did not change
+    std::array<uint8_t, cfg::NUM_SENSORS + 2> changes = {};
+    for (uint8_t i = scanRange.first; i <= scanRange.second; ++i) {
+        changes[i + 1] = std::abs(measurements[i] - this->prevMeasurements_[i]);
+    }
+
+    // the changes are only compared where the sensor and its neighbours were scanned in both frames
+    const uint64_t compared = scanned & this->prevScannedSensors_;
+    const auto isCompared   = [compared](const int16_t i) {
+        return i < 0 || i >= cfg::NUM_SENSORS || (compared & (1ull << i));
+    };
+
+    for (uint8_t i = scanRange.first; i <= scanRange.second; ++i) {
+        Statistics& stats = this->statistics_[i];
+        stats.min         = std::min(stats.min, measurements[i]);
+        stats.max         = std::max(stats.max, measurements[i]);
+        ++stats.numFrames;
+
+        // a line moving under the sensors changes the adjacent sensors as well, noise does not
+        if (isCompared(i - 1) && isCompared(i) && isCompared(i + 1)) {
+            const uint8_t neighbourChange = std::max(changes[i], changes[i + 2]);
+            stats.excessChangeSum += std::max(changes[i + 1] - neighbourChange, 0);
+            ++stats.numComparedFrames;
+        }
+    }
+
+    this->prevMeasurements_   = measurements;
+    this->prevScannedSensors_ = scanned;
+
+    if (++this->numWindowFrames_ == cfg::SENSOR_HEALTH_WINDOW_FRAMES) {
+        this->evaluate();
+        this->restartWindow();
+    }
+}
+
+void SensorHealthMonitor::evaluate() {
+    const auto isActive = [this](const int16_t i) {
+        if (i < 0 || i >= cfg::NUM_SENSORS) {
+            return true; // the edge sensors are evaluated by their only neighbour
+        }
+        const Statistics& stats = this->statistics_[i];
+        return stats.numFrames > 0 && stats.max - stats.min >= cfg::SENSOR_HEALTH_ACTIVE_MIN_RANGE;
+    };
+
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        const Statistics& stats = this->statistics_[i];
+        if (stats.numFrames < cfg::SENSOR_HEALTH_WINDOW_FRAMES / 2) {
+            continue;
+        }
+
+        sensorHealth_t health = sensorHealth_t::Ok;
+
+        if (stats.max - stats.min <= cfg::SENSOR_HEALTH_STUCK_MAX_RANGE && isActive(i - 1) &&
+            isActive(i + 1)) {
+            health = stats.min >= STUCK_HIGH_MIN_LEVEL ? sensorHealth_t::StuckHigh
+                                                       : sensorHealth_t::StuckLow;
+        } else if (stats.numComparedFrames >= cfg::SENSOR_HEALTH_WINDOW_FRAMES / 4 &&
+                   stats.excessChangeSum >=
+                       stats.numComparedFrames * cfg::SENSOR_HEALTH_NOISY_MIN_CHANGE) {
+            health = sensorHealth_t::Noisy;
+        }
+
+        this->health_[i] = health;
+        if (sensorHealth_t::Ok == health) {
+            this->faultySensors_ &= ~(1ull << i);
+        } else {
+            this->faultySensors_ |= 1ull << i;
+        }
+    }
+}
+
+void SensorHealthMonitor::restartWindow() {
+    this->statistics_.fill({255, 0, 0, 0, 0});
+    this->numWindowFrames_ = 0;
+}
@@ -0,0 +1,277 @@
+#include <SensorKernels.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include <cfg_sensor.hpp>
+
+#if defined(__ARM_FEATURE_DSP)
+#include <stm32f4xx.h>
+#endif // __ARM_FEATURE_DSP
+
+namespace kernel {
+
+namespace {
+
+#if defined(__ARM_FEATURE_DSP)
+
+uint32_t read32(const void* const ptr) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value)); // unaligned word access is supported by the Cortex-M4
+    return value;
+}
+
+#endif // __ARM_FEATURE_DSP
+
+// weighted sum of a window, unrolled at compile-time
+template <typename T, typename W, size_t... K>
+W dot(const T* const window, const W* const weights, std::index_sequence<K...>) {
+    return (... + (weights[K] * window[K]));
+}
+
+template <uint8_t RADIUS, typename T>
+void weightedAverageGeneric(const T* const values,
+                            const typename IntensityTraits<T>::accumulator_t* const weights,
+                            T* const OUT result, const uint8_t size) {
+    using traits = IntensityTraits<T>;
+
+    for (uint32_t i = RADIUS; i + RADIUS < size; ++i) {
+        result[i] = traits::fromAverage(
+            dot(&values[i - RADIUS], weights, std::make_index_sequence<2 * RADIUS + 1>{}));
+    }
+}
+
+// log2(1 + k / 2^LOG2_TABLE_BITS) for the mantissas of the logarithm calculation
+constexpr uint8_t LOG2_TABLE_BITS  = 6;
+constexpr uint32_t LOG2_TABLE_SIZE = 1 << LOG2_TABLE_BITS;
+
+// ln(x) = 2 * atanh((x - 1) / (x + 1)), the series converges quickly for x in [1, 2]
+constexpr double ln(const double x) {
+    const double y = (x - 1) / (x + 1);
+    double term    = y;
+    double result  = 0.0;
+    for (uint32_t n = 1; n < 40; n += 2) {
+        result += term / n;
+        term *= y * y;
+    }
+    return 2 * result;
+}
+
+constexpr auto LOG2_TABLE = [] {
+    std::array<float, LOG2_TABLE_SIZE + 1> table{};
+    for (uint32_t k = 0; k <= LOG2_TABLE_SIZE; ++k) {
+        table[k] =
+            static_cast<float>(ln(1.0 + static_cast<double>(k) / LOG2_TABLE_SIZE) / ln(2.0));
+    }
+    return table;
+}();
+
+// base-2 logarithm of a positive integer, the mantissa is interpolated linearly in the table
+float fastLog2(const uint32_t value) {
+    const uint32_t exponent = 31 - __builtin_clz(value);
+    const uint32_t mantissa = value << (31 - exponent); // the leading 1 is at bit 31
+    const uint32_t idx      = (mantissa >> (31 - LOG2_TABLE_BITS)) & (LOG2_TABLE_SIZE - 1);
+    const float frac =
+        static_cast<float>((mantissa << (LOG2_TABLE_BITS + 1)) >> 8) / static_cast<float>(1 << 24);
+    return exponent + LOG2_TABLE[idx] + (LOG2_TABLE[idx + 1] - LOG2_TABLE[idx]) * frac;
+}
+
+// the vertex of the parabola fitted to the points (-1, left), (0, center), (1, right)
+template <typename T>
+bool vertexOffset(const T left, const T center, const T right, float& OUT offset) {
+    const T curvature = left - 2 * center + right;
+    if (curvature >= 0) {
+        return false;
+    }
+
+    offset = 0.5f * static_cast<float>(left - right) / static_cast<float>(curvature);
+    return offset >= -1.0f && offset <= 1.0f;
+}
+
+template <typename T>
+typename IntensityTraits<T>::accumulator_t sumGeneric(const T* const values, const uint8_t size) {
+    typename IntensityTraits<T>::accumulator_t result = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        result += values[i];
+    }
+    return result;
+}
+
+} // namespace
+
+void removeCrosstalk(const uint8_t* const measurements, const uint8_t* const darkLevels,
+                     const uint16_t* const leftGains, const uint16_t* const rightGains,
+                     const uint8_t stride, uint8_t* const OUT result, const uint8_t size) {
+    const auto light = [measurements, darkLevels](const uint32_t i) {
+        return std::max(darkLevels[i] - measurements[i], 0);
+    };
+
+    for (uint32_t i = 0; i < size; ++i) {
+        int32_t value = (static_cast<int32_t>(measurements[i]) << 16) + (1 << 15);
+        if (i >= stride) {
+            value += leftGains[i] * light(i - stride);
+        }
+        if (i + stride < size) {
+            value += rightGains[i] * light(i + stride);
+        }
+        result[i] = static_cast<uint8_t>(std::min(value >> 16, 255));
+    }
+}
+
+void scale(const uint8_t* const measurements, const uint8_t* const whiteLevels,
+           const float* const gains, float* const OUT result, const uint8_t size) {
+    for (uint32_t i = 0; i < size; ++i) {
+        const int32_t diff = std::max(measurements[i] - whiteLevels[i], 0);
+        result[i]          = static_cast<float>(diff) * gains[i];
+    }
+}
+
+void scale(const uint8_t* const measurements, const uint8_t* const whiteLevels,
+           const uint32_t* const gains, q15_t* const OUT result, const uint8_t size) {
+    using traits = IntensityTraits<q15_t>;
+
+    uint8_t i = 0;
+
+#if defined(__ARM_FEATURE_DSP)
+    // saturating subtraction of 4 measurements at once
+    for (; i + 4 <= size; i += 4) {
+        const uint32_t diffs = __UQSUB8(read32(&measurements[i]), read32(&whiteLevels[i]));
+        for (uint8_t j = 0; j < 4; ++j) {
+            const uint32_t diff = (diffs >> (8 * j)) & 0xff;
+            result[i + j]       = static_cast<q15_t>((diff * gains[i + j] + (1u << 15)) >> 16);
+        }
+    }
+#endif // __ARM_FEATURE_DSP
+
+    for (; i < size; ++i) {
+        result[i] = traits::scale(measurements[i], whiteLevels[i], gains[i]);
+    }
+}
+
+void removeOffset(const float* const values, const float* const offsets, float* const OUT result,
+                  const uint8_t size) {
+    for (uint32_t i = 0; i < size; ++i) {
+        const float diff  = std::max(values[i] - offsets[i], 0.0f);
+        const float range = std::max(1.0f - offsets[i], std::numeric_limits<float>::min());
+        result[i]         = diff / range;
+    }
+}
+
+void removeOffset(const q15_t* const values, const q15_t* const offsets, q15_t* const OUT result,
+                  const uint8_t size) {
+    using traits = IntensityTraits<q15_t>;
+
+    uint8_t i = 0;
+
+#if defined(__ARM_FEATURE_DSP)
+    // saturating subtraction of 2 values at once, negative differences are clamped to 0 by USAT16
+    for (; i + 2 <= size; i += 2) {
+        const uint32_t diffs = __USAT16(__QSUB16(read32(&values[i]), read32(&offsets[i])), 15);
+        for (uint8_t j = 0; j < 2; ++j) {
+            const int32_t diff  = (diffs >> (16 * j)) & 0xffff;
+            const int32_t range = std::max<int32_t>(traits::ONE - offsets[i + j], 1);
+            result[i + j]       = static_cast<q15_t>((diff * traits::ONE + range / 2) / range);
+        }
+    }
+#endif // __ARM_FEATURE_DSP
+
+    for (; i < size; ++i) {
+        result[i] = traits::removeOffset(values[i], offsets[i]);
+    }
+}
+
+template <uint8_t RADIUS>
+void weightedAverage(const float* const values, const float* const weights,
+                     float* const OUT result, const uint8_t size) {
+    weightedAverageGeneric<RADIUS>(values, weights, result, size);
+}
+
+template <uint8_t RADIUS>
+void weightedAverage(const q15_t* const values, const int32_t* const weights,
+                     q15_t* const OUT result, const uint8_t size) {
+#if defined(__ARM_FEATURE_DSP)
+    // dual 16-bit multiply-accumulate of neighbouring taps
+    static constexpr uint8_t NUM_TAPS = 2 * RADIUS + 1;
+
+    uint32_t weightPairs[RADIUS];
+    for (uint8_t k = 1; k < NUM_TAPS; k += 2) {
+        weightPairs[k / 2] = __PKHBT(weights[k - 1], weights[k], 16);
+    }
+
+    for (uint32_t i = RADIUS; i + RADIUS < size; ++i) {
+        const q15_t* const window = &values[i - RADIUS];
+
+        int32_t sum = weights[NUM_TAPS - 1] * window[NUM_TAPS - 1];
+        for (uint8_t k = 0; k + 1 < NUM_TAPS; k += 2) {
+            sum = __SMLAD(read32(&window[k]), weightPairs[k / 2], sum);
+        }
+        result[i] = IntensityTraits<q15_t>::fromAverage(sum);
+    }
+#else
+    weightedAverageGeneric<RADIUS>(values, weights, result, size);
+#endif // __ARM_FEATURE_DSP
+}
+
+bool parabolaOffset(const float* const window, float& OUT offset) {
+    return vertexOffset(window[0], window[1], window[2], offset);
+}
+
+bool parabolaOffset(const q15_t* const window, float& OUT offset) {
+    return vertexOffset<int32_t>(window[0], window[1], window[2], offset);
+}
+
+// the logarithm of a Gaussian is a parabola, values are converted to Q24 integers for the table
+bool gaussianOffset(const float* const window, float& OUT offset) {
+    static constexpr float ONE = 1 << 24;
+
+    uint32_t values[3];
+    for (uint8_t i = 0; i < 3; ++i) {
+        // the responses of the matched filter are negative around the peaks
+        if (window[i] <= 0.0f) {
+            return false;
+        }
+        values[i] = static_cast<uint32_t>(window[i] * ONE);
+        if (values[i] == 0) {
+            return false;
+        }
+    }
+    return vertexOffset(fastLog2(values[0]), fastLog2(values[1]), fastLog2(values[2]), offset);
+}
+
+bool gaussianOffset(const q15_t* const window, float& OUT offset) {
+    for (uint8_t i = 0; i < 3; ++i) {
+        if (window[i] <= 0) {
+            return false;
+        }
+    }
+    return vertexOffset(fastLog2(window[0]), fastLog2(window[1]), fastLog2(window[2]), offset);
+}
+
+float sum(const float* const values, const uint8_t size) {
+    return sumGeneric(values, size);
+}
+
+int32_t sum(const q15_t* const values, const uint8_t size) {
+    return sumGeneric(values, size);
+}
+
+constexpr uint8_t GROUP_INTENSITY_RADIUS =
+    static_cast<uint8_t>(micro::ceil(cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS));
+
+template void weightedAverage<GROUP_INTENSITY_RADIUS>(const float* const, const float* const,
+                                                      float* const, const uint8_t);
+template void weightedAverage<GROUP_INTENSITY_RADIUS>(const q15_t* const, const int32_t* const,
+                                                      q15_t* const, const uint8_t);
+
+template void weightedAverage<cfg::LINE_POS_CALC_MATCHED_FILTER_RADIUS>(const float* const,
+                                                                       const float* const,
+                                                                       float* const,
+                                                                       const uint8_t);
+template void weightedAverage<cfg::LINE_POS_CALC_MATCHED_FILTER_RADIUS>(const q15_t* const,
+                                                                       const int32_t* const,
+                                                                       q15_t* const,
+                                                                       const uint8_t);
+
+} // namespace kernel
@@ -0,0 +1,94 @@
+#include <WhiteLevelStorage.hpp>
+#include <cstddef>
+
+namespace {
+
+constexpr uint32_t RECORD_TAG     = 0x4c564c57; // "WLVL"
+constexpr uint16_t RECORD_VERSION = 1;          // increment when the record layout changes
+constexpr uint32_t ERASED_TAG     = 0xffffffff;
+
+} // namespace
+
+WhiteLevelStorage::WhiteLevelStorage(Flash& flash) : flash_(flash) {}
+
+bool WhiteLevelStorage::load(Measurements& OUT whiteLevels) const {
+    bool found = false;
+
+    for (uint32_t slot = 0; slot < this->numSlots(); ++slot) {
+        Record record;
+        this->flash_.read(slot * sizeof(Record), &record, sizeof(Record));
+
+        if (ERASED_TAG == record.tag) {
+            break;
+        }
+
+        if (RECORD_TAG == record.tag && RECORD_VERSION == record.version &&
+            cfg::NUM_SENSORS == record.numSensors && checksum(record) == record.checksum) {
+            whiteLevels = record.whiteLevels;
+            found       = true;
+        }
+    }
+
+    return found;
+}
+
+bool WhiteLevelStorage::store(const Measurements& whiteLevels) {
+    Record record;
+    record.tag         = RECORD_TAG;
+    record.version     = RECORD_VERSION;
+    record.numSensors  = cfg::NUM_SENSORS;
+    record.whiteLevels = whiteLevels;
+    record.checksum    = checksum(record);
+
+    const uint32_t slot = this->firstFreeSlot();
+    if (slot == this->numSlots()) {
+        return false;
+    }
+
+    return this->flash_.write(slot * sizeof(Record), &record, sizeof(Record));
+}
+
+bool WhiteLevelStorage::compact() {
+    if (2 * this->firstFreeSlot() <= this->numSlots()) {
+        return true;
+    }
+
+    Measurements whiteLevels;
+    const bool found = this->load(whiteLevels);
+
+    if (!this->flash_.erase()) {
+        return false;
+    }
+
+    return !found || this->store(whiteLevels);
+}
+
+// FNV-1a hash of the record fields preceding the checksum
+uint32_t WhiteLevelStorage::checksum(const Record& record) {
+    static_assert(offsetof(Record, checksum) + sizeof(record.checksum) == sizeof(Record),
+                  "Record must not contain padding");
+
+    const uint8_t* const bytes = reinterpret_cast<const uint8_t*>(&record);
+
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(Record, checksum); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t WhiteLevelStorage::numSlots() const {
+    return this->flash_.size() / sizeof(Record);
+}
+
+uint32_t WhiteLevelStorage::firstFreeSlot() const {
+    uint32_t slot = 0;
+    for (; slot < this->numSlots(); ++slot) {
+        uint32_t tag;
+        this->flash_.read(slot * sizeof(Record), &tag, sizeof(tag));
+        if (ERASED_TAG == tag) {
+            break;
+        }
+    }
+    return slot;
+}
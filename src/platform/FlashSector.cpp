@@ -0,0 +1,41 @@
+#include <Flash.hpp>
+#include <cstring>
+
+#include <stm32f4xx_hal.h>
+
+FlashSector::FlashSector(const uint32_t sector, const uint32_t address, const uint32_t size)
+    : sector_(sector), address_(address), size_(size) {}
+
+void FlashSector::read(const uint32_t offset, void* const OUT data, const uint32_t size) const {
+    std::memcpy(data, reinterpret_cast<const void*>(this->address_ + offset), size);
+}
+
+bool FlashSector::write(const uint32_t offset, const void* const data, const uint32_t size) {
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    bool success               = true;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; success && i < size; ++i) {
+        success = HAL_OK == HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, this->address_ + offset + i,
+                                              bytes[i]);
+    }
+    HAL_FLASH_Lock();
+
+    return success;
+}
+
+bool FlashSector::erase() {
+    FLASH_EraseInitTypeDef eraseInit = {};
+    eraseInit.TypeErase              = FLASH_TYPEERASE_SECTORS;
+    eraseInit.Sector                 = this->sector_;
+    eraseInit.NbSectors              = 1;
+    eraseInit.VoltageRange           = FLASH_VOLTAGE_RANGE_3;
+
+    uint32_t sectorError = 0;
+
+    HAL_FLASH_Unlock();
+    const HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
+    HAL_FLASH_Lock();
+
+    return HAL_OK == status;
+}
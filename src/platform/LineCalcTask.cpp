@@ -1,7 +1,10 @@
+#include <LineDetectorCan.hpp>
 #include <LineFilter.hpp>
 #include <LinePatternCalculator.hpp>
 #include <LinePosCalculator.hpp>
 #include <SensorData.hpp>
+#include <SensorHealthMonitor.hpp>
+#include <WhiteLevelStorage.hpp>
 #include <cfg_board.hpp>
 #include <numeric>
 
@@ -16,14 +19,19 @@
 
 using namespace micro;
 
-extern queue_t<Measurements, 1> measurementsQueue;
+extern queue_t<TimedMeasurements, 1> measurementsQueue;
+extern queue_t<Crosstalk, 1> crosstalkQueue;
 
 CanManager vehicleCanManager(can_Vehicle);
 queue_t<SensorControlData, 1> sensorControlDataQueue;
 
 namespace {
 
-LinePosCalculator linePosCalc(true);
+LinePosCalculator linePosCalc(true, true, linePosEstimator_t::Centroid, lineSearch_t::Full);
+FlashSector whiteLevelFlash = flash_WhiteLevels;
+WhiteLevelStorage whiteLevelStorage(whiteLevelFlash);
+bool whiteLevelsStored = false;
+SensorHealthMonitor sensorHealthMonitor;
 LineFilter lineFilter;
 LinePatternCalculator linePatternCalc;
 
@@ -32,8 +40,10 @@ m_per_sec_t speed;
 meter_t distance;
 bool indicatorLedsEnabled = true;
 
-Measurements measurements;
+TimedMeasurements frame;
 SensorControlData sensorControl;
+uint8_t scanRangeRadius = 0;
+ScanRange scanRange     = FULL_SCAN_RANGE; // scan range of the received measurements
 
 CanFrameHandler vehicleCanFrameHandler;
 CanSubscriber::Id vehicleCanSubscriberId = CanSubscriber::INVALID_ID;
@@ -43,8 +53,18 @@ CanSubscriber::Id vehicleCanSubscriberId = CanSubscriber::INVALID_ID;
 uint32_t statisticsCounter                    = 0;
 millisecond_t statisticsStartTime             = millisecond_t(0);
 constexpr uint16_t STATISTICS_ITERATION_COUNT = 1000;
+std::array<uint16_t, NUM_FRAME_CLASSES> frameClassCounts{};
+static_assert(NUM_FRAME_CLASSES == can::FrontLineFrameClasses::NUM_CLASSES,
+              "All frame classes must be reported");
 #endif
 
+// The group intensities detect the lines in every domain. The matched filter is cheaper and more
+// accurate for the lines of the race track in the simulated frames, it is only selected for the
+// race track once it has been validated on recorded frames.
+lineDetector_t lineDetector(const linePatternDomain_t) {
+    return lineDetector_t::GroupIntensity;
+}
+
 const Leds& updateFailureLeds() {
     static constexpr float SENSOR_OFFSET = cfg::NUM_SENSORS / 2.0f - 0.5f;
 
@@ -88,6 +108,9 @@ void updateSensorControl(const Lines& lines, const bool isOk) {
 
     sensorControl.scanEnabled = true;
 
+    // white level calibration needs all the sensors
+    sensorControl.scanRangeRadius = linePosCalc.isWhiteLevelCalibrated() ? scanRangeRadius : 0;
+
     if (lines.size()) {
         const millimeter_t avgLinePos =
             std::accumulate(
@@ -111,19 +134,29 @@ void initializeVehicleCan() {
     vehicleCanFrameHandler.registerHandler(
         can::LineDetectControl::id(), [](const uint8_t* const data) {
             reinterpret_cast<const can::LineDetectControl*>(data)->acquire(
-                indicatorLedsEnabled, sensorControl.scanRangeRadius, domain);
+                indicatorLedsEnabled, scanRangeRadius, domain);
         });
 
+    vehicleCanFrameHandler.registerHandler(can::LineDetectRecalibrate::id(),
+                                           [](const uint8_t* const) {
+                                               linePosCalc.restartWhiteLevelCalibration();
+                                               whiteLevelsStored = false;
+                                           });
+
     const CanFrameIds rxFilter = vehicleCanFrameHandler.identifiers();
     CanFrameIds txFilter       = {PANEL_VERSION_FRONT == getPanelVersion() ? can::FrontLines::id()
                                                                            : can::RearLines::id(),
                             PANEL_VERSION_FRONT == getPanelVersion() ? can::FrontLinePattern::id()
                                                                            : can::RearLinePattern::id()};
+    txFilter.insert(PANEL_VERSION_FRONT == getPanelVersion() ? can::FrontLineSensorHealth::id()
+                                                             : can::RearLineSensorHealth::id());
 #if REPORT_STATISTICS
     if (PANEL_VERSION_FRONT == getPanelVersion()) {
         txFilter.insert(can::FrontLineStatistics::id());
+        txFilter.insert(can::FrontLineFrameClasses::id());
     } else if (PANEL_VERSION_REAR == getPanelVersion()) {
         txFilter.insert(can::RearLineStatistics::id());
+        txFilter.insert(can::RearLineFrameClasses::id());
     }
 #endif
     vehicleCanSubscriberId = vehicleCanManager.registerSubscriber(rxFilter, txFilter);
@@ -135,7 +168,23 @@ extern "C" void runLineCalcTask(void) {
     initializeVehicleCan();
 
     for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
-        measurements[i] = 0;
+        frame.measurements[i] = 0;
+    }
+
+    if (cfg::CROSSTALK_COMPENSATION_ENABLED) {
+        Crosstalk crosstalk;
+        crosstalkQueue.receive(crosstalk);
+        linePosCalc.setCrosstalk(crosstalk);
+    }
+
+    // the flash erase stalls the task for 1-2 s, it is only done at startup, before the detection
+    whiteLevelStorage.compact();
+
+    // reuses the white levels of the last calibration, detection starts on the first frame
+    Measurements whiteLevels;
+    if (whiteLevelStorage.load(whiteLevels)) {
+        linePosCalc.setWhiteLevels(whiteLevels);
+        whiteLevelsStored = true;
     }
 
 #if REPORT_STATISTICS
@@ -143,25 +192,53 @@ extern "C" void runLineCalcTask(void) {
 #endif
 
     while (true) {
-        measurementsQueue.receive(measurements);
+        measurementsQueue.receive(frame);
+
+        // faulty sensors are masked and reported when they change
+        const uint64_t faultySensors = linePosCalc.maskedSensors();
+        sensorHealthMonitor.update(frame.measurements, scanRange);
+        linePosCalc.setMaskedSensors(sensorHealthMonitor.faultySensors());
 
-        const auto maxLines               = domain == linePatternDomain_t::Labyrinth ? 4 : 3;
-        const LinePositions linePositions = linePosCalc.calculate(measurements, maxLines);
-        const Lines lines                 = lineFilter.update(linePositions, maxLines);
+        if (faultySensors != linePosCalc.maskedSensors()) {
+            if (PANEL_VERSION_FRONT == getPanelVersion()) {
+                vehicleCanManager.send<can::FrontLineSensorHealth>(vehicleCanSubscriberId,
+                                                                   linePosCalc.maskedSensors());
+            } else if (PANEL_VERSION_REAR == getPanelVersion()) {
+                vehicleCanManager.send<can::RearLineSensorHealth>(vehicleCanSubscriberId,
+                                                                  linePosCalc.maskedSensors());
+            }
+        }
+
+        const auto maxLines = domain == linePatternDomain_t::Labyrinth ? 4 : 3;
+        linePosCalc.setLineDetector(lineDetector(domain));
+        const LinePositions linePositions =
+            linePosCalc.calculate(frame.measurements, maxLines, scanRange);
+
+        if (!whiteLevelsStored && linePosCalc.isWhiteLevelCalibrated()) {
+            whiteLevelStorage.store(linePosCalc.whiteLevels());
+            whiteLevelsStored = true;
+        }
+
+        const Lines lines = lineFilter.update(linePositions, maxLines, frame.time);
         linePatternCalc.update(domain, lines, distance,
                                PANEL_VERSION_FRONT == getPanelVersion() ? sgn(speed) : -sgn(speed));
 
+        // the lines are sent at their expected positions at the time of their reception,
+        // compensating the latency of the calculation and the transmission
+        const Lines txLines = lineFilter.predict(lines, getTime() + cfg::LINE_CAN_TX_LATENCY);
+
         if (PANEL_VERSION_FRONT == getPanelVersion()) {
-            vehicleCanManager.send<can::FrontLines>(vehicleCanSubscriberId, lines);
+            vehicleCanManager.send<can::FrontLines>(vehicleCanSubscriberId, txLines);
             vehicleCanManager.send<can::FrontLinePattern>(vehicleCanSubscriberId,
                                                           linePatternCalc.pattern());
         } else if (PANEL_VERSION_REAR == getPanelVersion()) {
-            vehicleCanManager.send<can::RearLines>(vehicleCanSubscriberId, lines);
+            vehicleCanManager.send<can::RearLines>(vehicleCanSubscriberId, txLines);
             vehicleCanManager.send<can::RearLinePattern>(vehicleCanSubscriberId,
                                                          linePatternCalc.pattern());
         }
 
 #if REPORT_STATISTICS
+        ++frameClassCounts[static_cast<uint8_t>(linePosCalc.frameClass())];
         statisticsCounter++;
         if (statisticsCounter == STATISTICS_ITERATION_COUNT) {
             const millisecond_t endTime = getTime();
@@ -171,11 +248,16 @@ extern "C" void runLineCalcTask(void) {
             if (PANEL_VERSION_FRONT == getPanelVersion()) {
                 vehicleCanManager.send<can::FrontLineStatistics>(
                     vehicleCanSubscriberId, processingTime_ms, STATISTICS_ITERATION_COUNT);
+                vehicleCanManager.send<can::FrontLineFrameClasses>(vehicleCanSubscriberId,
+                                                                   frameClassCounts);
             } else if (PANEL_VERSION_REAR == getPanelVersion()) {
                 vehicleCanManager.send<can::RearLineStatistics>(
                     vehicleCanSubscriberId, processingTime_ms, STATISTICS_ITERATION_COUNT);
+                vehicleCanManager.send<can::RearLineFrameClasses>(vehicleCanSubscriberId,
+                                                                  frameClassCounts);
             }
 
+            frameClassCounts.fill(0);
             statisticsCounter   = 0;
             statisticsStartTime = endTime;
         }
@@ -187,6 +269,7 @@ extern "C" void runLineCalcTask(void) {
 
         const bool isOk = !vehicleCanManager.hasTimedOut(vehicleCanSubscriberId);
         updateSensorControl(lines, isOk);
+        scanRange = sensorControl.scanRange();
         sensorControlDataQueue.send(sensorControl);
     }
 }
@@ -6,11 +6,13 @@
 #include <micro/port/queue.hpp>
 #include <micro/port/task.hpp>
 #include <micro/utils/str_utils.hpp>
+#include <micro/utils/timer.hpp>
 
 using namespace micro;
 
 extern queue_t<SensorControlData, 1> sensorControlDataQueue;
-queue_t<Measurements, 1> measurementsQueue;
+queue_t<TimedMeasurements, 1> measurementsQueue;
+queue_t<Crosstalk, 1> crosstalkQueue;
 
 namespace {
 
@@ -19,39 +21,40 @@ SensorHandler sensorHandler(spi_Sensor,
                              gpio_SS_ADC5},
                             gpio_LE_OPTO, gpio_OE_OPTO, gpio_LE_IND, gpio_LE_IND);
 
-Measurements measurements;
+TimedMeasurements frame;
 SensorControlData sensorControl;
-
-std::pair<uint8_t, uint8_t> getScanRange() {
-    std::pair<uint8_t, uint8_t> range = {0, cfg::NUM_SENSORS - 1};
-
-    if (sensorControl.scanRangeRadius > 0) {
-        range.first = micro::max(sensorControl.scanRangeCenter, sensorControl.scanRangeRadius) -
-                      sensorControl.scanRangeRadius;
-        range.second = micro::min(sensorControl.scanRangeCenter + sensorControl.scanRangeRadius,
-                                  cfg::NUM_SENSORS - 1);
-    }
-
-    return range;
-}
+CrosstalkCalibration crosstalkCalibration;
 
 } // namespace
 
 extern "C" void runSensorTask(void) {
     sensorHandler.initialize();
 
+    // the crosstalk of the sensors lit in parallel is removed by the line position calculation
+    if (cfg::CROSSTALK_COMPENSATION_ENABLED) {
+        CrosstalkMeasurements crosstalkMeasurements;
+        while (!crosstalkCalibration.isCalibrated()) {
+            sensorHandler.readCrosstalk(crosstalkMeasurements);
+            crosstalkCalibration.update(crosstalkMeasurements);
+        }
+        crosstalkQueue.send(crosstalkCalibration.crosstalk());
+    }
+
     while (true) {
         sensorHandler.writeLeds(sensorControl.leds);
 
         for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
-            measurements[i] = 0;
+            frame.measurements[i] = 0;
         }
 
+        // the frame is timestamped when it is read, not when the line calculation receives it
+        const millisecond_t readStartTime = getTime();
         if (sensorControl.scanEnabled) {
-            sensorHandler.readSensors(measurements, getScanRange());
+            sensorHandler.readSensors(frame.measurements, sensorControl.scanRange());
         }
+        frame.time = readStartTime + (getTime() - readStartTime) / 2;
 
-        measurementsQueue.send(measurements);
+        measurementsQueue.send(frame);
         sensorControlDataQueue.receive(sensorControl);
     }
 }
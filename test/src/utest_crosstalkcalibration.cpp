@@ -0,0 +1,65 @@
+#include <CrosstalkCalibration.hpp>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr uint8_t STRIDE = 4;
+constexpr uint8_t DARK   = 240;
+
+// Measurements decrease with the light like on the panel: every sensor measures 200 levels below
+// the dark level from its own LED, and the given fraction of it from the LEDs STRIDE sensors away.
+void createMeasurements(const float leftCrosstalk, const float rightCrosstalk,
+                        CrosstalkMeasurements& OUT meas) {
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        meas.dark[i]     = DARK - rand() % 2;
+        meas.lit[i]      = DARK - 200 - rand() % 2;
+        meas.litLeft[i]  = i >= STRIDE ? DARK - 200 * leftCrosstalk - rand() % 2 : meas.dark[i];
+        meas.litRight[i] = i + STRIDE < cfg::NUM_SENSORS
+                               ? DARK - 200 * rightCrosstalk - rand() % 2
+                               : meas.dark[i];
+    }
+}
+
+} // namespace
+
+TEST(CrosstalkCalibration, calibrate) {
+    CrosstalkCalibration calibration(STRIDE);
+    CrosstalkMeasurements measurements;
+
+    for (uint8_t i = 0; i < cfg::CROSSTALK_CALIB_FRAMES; ++i) {
+        // no crosstalk is removed until the calibration has finished
+        EXPECT_FALSE(calibration.isCalibrated());
+        EXPECT_EQ(0, calibration.crosstalk().stride);
+
+        createMeasurements(0.1f, 0.2f, measurements);
+        calibration.update(measurements);
+    }
+
+    ASSERT_TRUE(calibration.isCalibrated());
+    const Crosstalk& crosstalk = calibration.crosstalk();
+    EXPECT_EQ(STRIDE, crosstalk.stride);
+
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        EXPECT_NEAR(DARK, crosstalk.dark[i], 1);
+        EXPECT_NEAR(i >= STRIDE ? 0.1f : 0.0f, crosstalk.left[i] / 65536.0f, 0.01f);
+        EXPECT_NEAR(i + STRIDE < cfg::NUM_SENSORS ? 0.2f : 0.0f, crosstalk.right[i] / 65536.0f,
+                    0.01f);
+    }
+}
+
+TEST(CrosstalkCalibration, invalid_measurements) {
+    CrosstalkCalibration calibration(STRIDE);
+    CrosstalkMeasurements measurements;
+
+    for (uint8_t i = 0; i < cfg::CROSSTALK_CALIB_FRAMES; ++i) {
+        createMeasurements(1.0f, 0.1f, measurements);
+        measurements.lit[20] = 255; // no light from the LED of the sensor
+        calibration.update(measurements);
+    }
+
+    const Crosstalk& crosstalk = calibration.crosstalk();
+    EXPECT_EQ(cfg::CROSSTALK_MAX_GAIN, crosstalk.left[10]);
+    EXPECT_EQ(0, crosstalk.left[20 + STRIDE]);
+    EXPECT_EQ(0, crosstalk.right[20 - STRIDE]);
+}
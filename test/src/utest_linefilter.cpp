@@ -50,12 +50,48 @@ void expectEq(const LinePositions& linePositions, const Lines& lines) {
     }
 }
 
+// mean error of the filtered position of a noisy line moving along a sine wave
+template <typename line_state_t>
+float trackingError() {
+    static constexpr uint32_t NUM_FRAMES = 500;
+
+    BasicLineFilter<cfg::MAX_NUM_FILTERED_LINES, line_state_t> lineFilter;
+    float error         = 0.0f;
+    uint32_t numSamples = 0;
+
+    for (uint32_t i = 0; i < NUM_FRAMES; ++i) {
+        const LinePositions linePositions = {{millimeter_t(30 * std::sin(i / 15.0f)), 1.0f}};
+
+        const Lines lines = lineFilter.update(addNoise(linePositions), Line::MAX_NUM_LINES);
+        if (lines.size()) {
+            error += abs(lines.begin()->pos - linePositions.begin()->pos).get();
+            ++numSamples;
+        }
+    }
+
+    EXPECT_EQ(NUM_FRAMES - cfg::LINE_FILTER_HYSTERESIS + 1, numSamples);
+    return error / numSamples;
+}
+
+template <typename filter_t>
+class LineFilterTest : public ::testing::Test {};
+
+using LongHistoryLineState = BasicSampleHistoryLineState<8, 2>;
+
+// the line filter of the panel, and instantiations with less lines and other line states
+using LineFilterTypes =
+    ::testing::Types<LineFilter, BasicLineFilter<3, SampleHistoryLineState>,
+                     BasicLineFilter<3, AlphaBetaLineState>, BasicLineFilter<3, KalmanLineState>,
+                     BasicLineFilter<cfg::MAX_NUM_FILTERED_LINES, LongHistoryLineState>>;
+
 } // namespace
 
-TEST(LineFilter, one_line_few_detections) {
+TYPED_TEST_SUITE(LineFilterTest, LineFilterTypes);
+
+TYPED_TEST(LineFilterTest, one_line_few_detections) {
     LinePositions linePositions = {{millimeter_t(0), 1.0f}};
 
-    LineFilter lineFilter;
+    TypeParam lineFilter;
     Lines lines;
 
     for (uint32_t i = 0; i < cfg::LINE_FILTER_HYSTERESIS - 1; ++i) {
@@ -65,10 +101,10 @@ TEST(LineFilter, one_line_few_detections) {
     EXPECT_EQ(0, lines.size());
 }
 
-TEST(LineFilter, one_line) {
+TYPED_TEST(LineFilterTest, one_line) {
     LinePositions linePositions = {{millimeter_t(0), 1.0f}};
 
-    LineFilter lineFilter;
+    TypeParam lineFilter;
     Lines lines;
 
     for (uint32_t i = 0; i < cfg::LINE_FILTER_HYSTERESIS; ++i) {
@@ -78,11 +114,11 @@ TEST(LineFilter, one_line) {
     expectEq(linePositions, lines);
 }
 
-TEST(LineFilter, one_line_noise) {
+TYPED_TEST(LineFilterTest, one_line_noise) {
     LinePositions linePositions_base = {{millimeter_t(0), 1.0f}};
     LinePositions linePositions;
 
-    LineFilter lineFilter;
+    TypeParam lineFilter;
     Lines lines;
 
     for (uint32_t i = 0; i < cfg::LINE_FILTER_HYSTERESIS; ++i) {
@@ -93,13 +129,13 @@ TEST(LineFilter, one_line_noise) {
     expectEq(linePositions, lines);
 }
 
-TEST(LineFilter, one_line_noise_false_positives) {
+TYPED_TEST(LineFilterTest, one_line_noise_false_positives) {
     LinePositions linePositions_base               = {{millimeter_t(0), 1.0f}};
     LinePositions linePositionsFalsePositives_base = {{millimeter_t(0), 1.0f},
                                                       {millimeter_t(50), 1.0f}};
     LinePositions linePositions;
 
-    LineFilter lineFilter;
+    TypeParam lineFilter;
     Lines lines;
 
     for (uint32_t i = 0; i < cfg::LINE_FILTER_HYSTERESIS; ++i) {
@@ -110,11 +146,11 @@ TEST(LineFilter, one_line_noise_false_positives) {
     expectEq(linePositions, lines);
 }
 
-TEST(LineFilter, one_line_true_negatives) {
+TYPED_TEST(LineFilterTest, one_line_true_negatives) {
     LinePositions linePositions              = {{millimeter_t(0), 1.0f}};
     LinePositions linePositionsTrueNegatives = {};
 
-    LineFilter lineFilter;
+    TypeParam lineFilter;
     Lines lines;
 
     for (uint32_t i = 0; i < cfg::LINE_FILTER_HYSTERESIS; ++i) {
@@ -134,13 +170,13 @@ TEST(LineFilter, one_line_true_negatives) {
     EXPECT_EQ(0, lines.size());
 }
 
-TEST(LineFilter, one_moving_line_true_negatives) {
+TYPED_TEST(LineFilterTest, one_moving_line_true_negatives) {
     static constexpr millimeter_t MOVE_DISTANCE = {1};
 
     LinePositions linePositions              = {{millimeter_t(0), 1.0f}};
     LinePositions linePositionsTrueNegatives = {};
 
-    LineFilter lineFilter;
+    TypeParam lineFilter;
     Lines lines;
 
     for (uint32_t i = 0; i < cfg::LINE_FILTER_HYSTERESIS; ++i) {
@@ -162,3 +198,90 @@ TEST(LineFilter, one_moving_line_true_negatives) {
 
     EXPECT_EQ(0, lines.size());
 }
+
+TYPED_TEST(LineFilterTest, multiple_moving_lines_missed_detection) {
+    static constexpr millimeter_t MOVE_DISTANCE = {2};
+
+    LinePositions linePositions = {{millimeter_t(-40), 1.0f},
+                                   {millimeter_t(0), 1.0f},
+                                   {millimeter_t(40), 1.0f}};
+
+    TypeParam lineFilter;
+    Lines lines;
+
+    for (uint32_t i = 0; i < cfg::LINE_FILTER_HYSTERESIS; ++i) {
+        linePositions = move(linePositions, MOVE_DISTANCE);
+        lines         = lineFilter.update(addNoise(linePositions), Line::MAX_NUM_LINES);
+    }
+
+    expectEq(linePositions, lines);
+
+    // the middle line is not detected in one frame, the others keep moving
+    linePositions        = move(linePositions, MOVE_DISTANCE);
+    LinePositions missed = linePositions;
+    missed.erase(std::next(missed.begin()));
+    lines = lineFilter.update(addNoise(missed), Line::MAX_NUM_LINES);
+
+    expectEq(linePositions, lines);
+
+    for (uint32_t i = 0; i < cfg::LINE_FILTER_HYSTERESIS; ++i) {
+        linePositions = move(linePositions, MOVE_DISTANCE);
+        lines         = lineFilter.update(addNoise(linePositions), Line::MAX_NUM_LINES);
+    }
+
+    expectEq(linePositions, lines);
+}
+
+TYPED_TEST(LineFilterTest, moving_line_prediction) {
+    static constexpr millimeter_t MOVE_DISTANCE = {2};
+    static constexpr millisecond_t FRAME_PERIOD = {5};
+
+    LinePositions linePositions = {{millimeter_t(0), 1.0f}};
+
+    TypeParam lineFilter;
+    Lines lines;
+    millisecond_t time;
+
+    for (uint32_t i = 0; i < 2 * cfg::LINE_FILTER_HYSTERESIS; ++i) {
+        time += FRAME_PERIOD;
+        linePositions = move(linePositions, MOVE_DISTANCE);
+        lines         = lineFilter.update(linePositions, Line::MAX_NUM_LINES, time);
+    }
+
+    expectEq(linePositions, lines);
+
+    // the line is predicted to the time of the next frame, closer to its position than reported
+    const millimeter_t nextPos = linePositions.begin()->pos + MOVE_DISTANCE;
+    const Lines predicted      = lineFilter.predict(lines, time + FRAME_PERIOD);
+
+    ASSERT_EQ(1, predicted.size());
+    EXPECT_EQ(lines.begin()->id, predicted.begin()->id);
+    EXPECT_LT(abs(predicted.begin()->pos - nextPos), abs(lines.begin()->pos - nextPos));
+}
+
+TYPED_TEST(LineFilterTest, untimed_prediction) {
+    static constexpr millimeter_t MOVE_DISTANCE = {2};
+
+    LinePositions linePositions = {{millimeter_t(0), 1.0f}};
+
+    TypeParam lineFilter;
+    Lines lines;
+
+    for (uint32_t i = 0; i < 2 * cfg::LINE_FILTER_HYSTERESIS; ++i) {
+        linePositions = move(linePositions, MOVE_DISTANCE);
+        lines         = lineFilter.update(linePositions, Line::MAX_NUM_LINES);
+    }
+
+    // without the frame period the lines are not extrapolated
+    const Lines predicted = lineFilter.predict(lines, millisecond_t(100));
+
+    ASSERT_EQ(1, predicted.size());
+    EXPECT_EQ(lines.begin()->pos, predicted.begin()->pos);
+}
+
+TEST(LineFilter, line_states) {
+    // the recursive states smooth the noise of the detections
+    const float historyError = trackingError<SampleHistoryLineState>();
+    EXPECT_GT(historyError, trackingError<AlphaBetaLineState>());
+    EXPECT_GT(historyError, trackingError<KalmanLineState>());
+}
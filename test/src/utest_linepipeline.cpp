@@ -0,0 +1,88 @@
+#include <LinePipeline.hpp>
+
+#include <micro/math/numeric.hpp>
+#include <micro/test/utils.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace micro;
+
+namespace {
+
+constexpr size_t NUM_FRAMES = 2000;
+
+// creates frames of a single line moving across the sensors, and a second line appearing
+void createFrames(std::vector<Measurements>& frames, std::vector<meter_t>& distances,
+                  std::vector<m_per_sec_t>& speeds) {
+    static constexpr double SIGMA = 1.0;
+
+    frames.resize(NUM_FRAMES);
+    distances.resize(NUM_FRAMES);
+    speeds.resize(NUM_FRAMES);
+
+    for (size_t f = 0; f < NUM_FRAMES; ++f) {
+        micro::vector<float, 2> linePositions = {
+            LinePosCalculator::linePosToOptoPos(millimeter_t(100 * std::sin(f / 200.0)))};
+        if ((f / 300) % 2) {
+            linePositions.push_back(linePositions[0] + 12);
+        }
+
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            double value = rand() % 20;
+            for (const float linePos : linePositions) {
+                const double z_score = (i - linePos) / SIGMA;
+                value += 200 * std::exp(-0.5 * z_score * z_score);
+            }
+            frames[f][i] = static_cast<uint8_t>(std::min(value, 255.0));
+        }
+
+        distances[f] = meter_t(f * 0.01f);
+        speeds[f]    = m_per_sec_t(1.0f);
+    }
+}
+
+} // namespace
+
+TEST(LinePipeline, batch_equals_single_frames) {
+    static constexpr size_t MAX_LINES = 4;
+
+    std::vector<Measurements> frames;
+    std::vector<meter_t> distances;
+    std::vector<m_per_sec_t> speeds;
+    createFrames(frames, distances, speeds);
+
+    std::vector<Lines> lines(NUM_FRAMES);
+    std::vector<LinePattern> patterns(NUM_FRAMES);
+
+    LinePipeline pipeline(false);
+    pipeline.run(linePatternDomain_t::Race, MAX_LINES, frames.data(), distances.data(),
+                 speeds.data(), NUM_FRAMES, lines.data(), patterns.data());
+
+    LinePosCalculator linePosCalc(false);
+    LineFilter lineFilter;
+    LinePatternCalculator linePatternCalc;
+    size_t numFramesWithLines = 0;
+
+    for (size_t f = 0; f < NUM_FRAMES; ++f) {
+        const LinePositions linePositions = linePosCalc.calculate(frames[f], MAX_LINES);
+        const Lines expectedLines         = lineFilter.update(linePositions, MAX_LINES);
+        linePatternCalc.update(linePatternDomain_t::Race, expectedLines, distances[f],
+                               sgn(speeds[f]));
+
+        ASSERT_EQ(expectedLines.size(), lines[f].size());
+        for (size_t j = 0; j < expectedLines.size(); ++j) {
+            const Line& expected = *std::next(expectedLines.begin(), j);
+            const Line& line     = *std::next(lines[f].begin(), j);
+            EXPECT_EQ(expected.pos, line.pos);
+            EXPECT_EQ(expected.id, line.id);
+        }
+        EXPECT_EQ_MICRO_LINE_PATTERN(linePatternCalc.pattern(), patterns[f]);
+
+        if (!lines[f].empty()) {
+            numFramesWithLines++;
+        }
+    }
+
+    EXPECT_LT(NUM_FRAMES / 2, numFramesWithLines);
+}
@@ -19,19 +19,20 @@ namespace {
 
 constexpr uint32_t NUM_TESTS_PER_SCENARIO = 10000;
 
+template <typename calculator_t = LinePosCalculator>
 void createMeasurements(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>& lines,
-                        Measurements& meas) {
+                        typename calculator_t::Measurements& meas) {
     static const double RANDOM_WEIGHT = 0.25;
     static const double SIGMA         = 1.0;
     static const double MAX_Z_SCORE   = 1.0 / (SIGMA * std::sqrt(2 * M_PI));
 
-    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+    for (uint8_t i = 0; i < calculator_t::NUM_SENSORS; ++i) {
         meas[i] = 0;
     }
 
-    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+    for (uint8_t i = 0; i < calculator_t::NUM_SENSORS; ++i) {
         for (millimeter_t linePos : lines) {
-            const double z_score = (i - LinePosCalculator::linePosToOptoPos(linePos)) / SIGMA;
+            const double z_score = (i - calculator_t::linePosToOptoPos(linePos)) / SIGMA;
             const double value =
                 1.0 / (SIGMA * std::sqrt(2 * M_PI)) * exp(-0.5 * z_score * z_score);
             const float random_mul = micro::lerp<uint32_t, double>(
@@ -45,18 +46,22 @@ void createMeasurements(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>&
     }
 }
 
-void test(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>& lines) {
-    LinePosCalculator linePosCalculator(false);
-    Measurements measurements;
+template <typename calculator_t = LinePosCalculator>
+void test(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>& lines,
+          const lineDetector_t lineDetector         = lineDetector_t::GroupIntensity,
+          const linePosEstimator_t linePosEstimator = linePosEstimator_t::Centroid) {
+    calculator_t linePosCalculator(false, false, linePosEstimator);
+    linePosCalculator.setLineDetector(lineDetector);
+    typename calculator_t::Measurements measurements;
 
     for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
-        createMeasurements(lines, measurements);
+        createMeasurements<calculator_t>(lines, measurements);
 
 #if PRINT_MEASUREMENTS
         std::cout << "Test measurements:";
-        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        for (uint8_t i = 0; i < calculator_t::NUM_SENSORS; ++i) {
             std::cout << std::setw(3) << std::to_string(measurements[i]);
-            if (i < cfg::NUM_SENSORS - 1) {
+            if (i < calculator_t::NUM_SENSORS - 1) {
                 std::cout << ",";
             } else {
                 std::cout << std::endl;
@@ -75,6 +80,70 @@ void test(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>& lines) {
     }
 }
 
+void testFixedPoint(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>& lines) {
+    static constexpr millimeter_t SENSOR_PITCH = cfg::OPTO_ARRAY_LENGTH / (cfg::NUM_SENSORS - 1);
+
+    BasicLinePosCalculator<float> floatCalculator(false);
+    BasicLinePosCalculator<q15_t> fixedPointCalculator(false);
+    Measurements measurements;
+    uint32_t numTieBreaks = 0;
+
+    for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+        createMeasurements(lines, measurements);
+
+        const auto expected = floatCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        const auto linePositions =
+            fixedPointCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        ASSERT_EQ(expected.size(), linePositions.size());
+        for (size_t j = 0; j < expected.size(); ++j) {
+            const auto& exp  = *std::next(expected.begin(), j);
+            const auto& line = *std::next(linePositions.begin(), j);
+            EXPECT_NEAR_UNIT(exp.pos, line.pos, SENSOR_PITCH);
+            EXPECT_NEAR(exp.probability, line.probability, 0.01f);
+
+            if (abs(exp.pos - line.pos) > millimeter_t(0.5f)) {
+                numTieBreaks++;
+            }
+        }
+    }
+
+    // the peak may only move to the adjacent group when the two groups are equal within Q15
+    // resolution
+    EXPECT_GE(NUM_TESTS_PER_SCENARIO / 1000, numTieBreaks);
+}
+
+// the coarse-to-fine search finds the same lines as the full search
+void testCoarseToFine(const micro::vector<millimeter_t, Line::MAX_NUM_LINES>& lines,
+                      const lineDetector_t lineDetector) {
+    LinePosCalculator fullCalculator(false, false, linePosEstimator_t::Centroid,
+                                     lineSearch_t::Full);
+    LinePosCalculator coarseToFineCalculator(false, false, linePosEstimator_t::Centroid,
+                                             lineSearch_t::CoarseToFine);
+    fullCalculator.setLineDetector(lineDetector);
+    coarseToFineCalculator.setLineDetector(lineDetector);
+    Measurements measurements;
+
+    for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+        createMeasurements(lines, measurements);
+
+        const auto expected = fullCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        const auto linePositions =
+            coarseToFineCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        ASSERT_EQ(expected.size(), linePositions.size());
+        for (size_t j = 0; j < expected.size(); ++j) {
+            const auto& exp  = *std::next(expected.begin(), j);
+            const auto& line = *std::next(linePositions.begin(), j);
+            EXPECT_NEAR_UNIT(exp.pos, line.pos, millimeter_t(0.01f));
+        }
+    }
+}
+
+void createBackground(const int8_t noise, Measurements& meas) {
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        meas[i] = 40 + 5 * (i % 7) + noise;
+    }
+}
+
 } // namespace
 
 TEST(LinePosCalculator, one_line_center) {
@@ -104,3 +173,538 @@ TEST(LinePosCalculator, two_lines_close_right) {
 TEST(LinePosCalculator, two_lines_far) {
     test({millimeter_t(-80), millimeter_t(70)});
 }
+
+TEST(LinePosCalculator, matched_filter) {
+    static constexpr lineDetector_t MATCHED_FILTER = lineDetector_t::MatchedFilter;
+
+    test({millimeter_t(0)}, MATCHED_FILTER);
+    test({millimeter_t(-100)}, MATCHED_FILTER);
+    test({millimeter_t(100)}, MATCHED_FILTER);
+    test({millimeter_t(-10), millimeter_t(28)}, MATCHED_FILTER);
+    test({millimeter_t(-120), millimeter_t(-90)}, MATCHED_FILTER);
+    test({millimeter_t(70), millimeter_t(100)}, MATCHED_FILTER);
+    test({millimeter_t(-80), millimeter_t(70)}, MATCHED_FILTER);
+
+    // the responses around the peaks are negative, they are not fitted by the Gaussian estimator
+    static constexpr linePosEstimator_t GAUSSIAN = linePosEstimator_t::Gaussian;
+    test({millimeter_t(0)}, MATCHED_FILTER, GAUSSIAN);
+    test({millimeter_t(-10), millimeter_t(28)}, MATCHED_FILTER, GAUSSIAN);
+    test({millimeter_t(-120), millimeter_t(0), millimeter_t(110)}, MATCHED_FILTER, GAUSSIAN);
+
+    // the results of the previous detector are not reused after switching
+    LinePosCalculator linePosCalculator(false);
+    LinePosCalculator matchedFilterCalculator(false);
+    matchedFilterCalculator.setLineDetector(MATCHED_FILTER);
+    Measurements measurements;
+    createMeasurements({millimeter_t(33)}, measurements);
+
+    linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+    linePosCalculator.setLineDetector(MATCHED_FILTER);
+    const auto linePositions = linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+    const auto expected = matchedFilterCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+    ASSERT_EQ(1, linePositions.size());
+    ASSERT_EQ(1, expected.size());
+    EXPECT_NEAR_UNIT(expected.begin()->pos, linePositions.begin()->pos, millimeter_t(0.01f));
+    EXPECT_EQ(expected.begin()->probability, linePositions.begin()->probability);
+}
+
+TEST(LinePosCalculator, fixed_point) {
+    testFixedPoint({millimeter_t(0)});
+    testFixedPoint({millimeter_t(-100)});
+    testFixedPoint({millimeter_t(-10), millimeter_t(28)});
+    testFixedPoint({millimeter_t(-80), millimeter_t(70)});
+}
+
+TEST(LinePosCalculator, sensor_arrays) {
+    test<BasicLinePosCalculator<float, SensorArray32>>({millimeter_t(-60), millimeter_t(50)});
+    test<BasicLinePosCalculator<q15_t, SensorArray32>>({millimeter_t(-60), millimeter_t(50)});
+    test<BasicLinePosCalculator<float, SensorArray64>>(
+        {millimeter_t(-160), millimeter_t(-10), millimeter_t(150)});
+    test<BasicLinePosCalculator<q15_t, SensorArray64>>(
+        {millimeter_t(-160), millimeter_t(-10), millimeter_t(150)});
+}
+
+// All 64 bits of the masks are set when every sensor changes, the runs of the changed sensors
+// reach the last sensor of the array.
+TEST(LinePosCalculator, sensor_array_64_full_range) {
+    using float_calculator_t = BasicLinePosCalculator<float, SensorArray64>;
+    using q15_calculator_t   = BasicLinePosCalculator<q15_t, SensorArray64>;
+
+    test<float_calculator_t>(
+        {float_calculator_t::optoIdxToLinePos(4), float_calculator_t::optoIdxToLinePos(59)});
+    test<q15_calculator_t>(
+        {q15_calculator_t::optoIdxToLinePos(4), q15_calculator_t::optoIdxToLinePos(59)});
+}
+
+TEST(LinePosCalculator, white_level_calibration_converged) {
+    LinePosCalculator linePosCalculator(true);
+    Measurements measurements;
+    createBackground(0, measurements);
+
+    for (uint16_t i = 0; i < cfg::WHITE_LEVEL_CALIB_MIN_FRAMES; ++i) {
+        EXPECT_FALSE(linePosCalculator.isWhiteLevelCalibrated());
+        EXPECT_EQ(0, linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES).size());
+    }
+    EXPECT_TRUE(linePosCalculator.isWhiteLevelCalibrated());
+
+    Measurements lineMeasurements;
+    createMeasurements({millimeter_t(30)}, lineMeasurements);
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        measurements[i] = std::min<uint32_t>(measurements[i] + lineMeasurements[i], 255);
+    }
+
+    const auto linePositions = linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+    ASSERT_EQ(1, linePositions.size());
+    EXPECT_NEAR_UNIT(millimeter_t(30), linePositions.begin()->pos, millimeter_t(4));
+}
+
+TEST(LinePosCalculator, white_level_calibration_noisy) {
+    LinePosCalculator linePosCalculator(true);
+    Measurements measurements;
+
+    for (uint16_t i = 0; i < cfg::WHITE_LEVEL_CALIB_MAX_FRAMES; ++i) {
+        EXPECT_FALSE(linePosCalculator.isWhiteLevelCalibrated());
+        createBackground(i % 2 ? 10 : -10, measurements);
+        linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+    }
+    EXPECT_TRUE(linePosCalculator.isWhiteLevelCalibrated());
+}
+
+TEST(LinePosCalculator, white_level_adaptation) {
+    static constexpr millimeter_t LINE_POS = millimeter_t(30);
+    static constexpr int8_t BACKGROUND_INCR = 12;
+
+    LinePosCalculator linePosCalculator(true, true);
+    Measurements background, measurements, lineMeasurements;
+    createBackground(0, background);
+
+    for (uint16_t i = 0; i < cfg::WHITE_LEVEL_CALIB_MIN_FRAMES; ++i) {
+        linePosCalculator.calculate(background, Line::MAX_NUM_LINES);
+    }
+    ASSERT_TRUE(linePosCalculator.isWhiteLevelCalibrated());
+
+    // the surface gets darker, while the car is following the line
+    createBackground(BACKGROUND_INCR, measurements);
+    for (uint32_t i = 0; i < 500; ++i) {
+        createMeasurements({LINE_POS}, lineMeasurements);
+        for (uint8_t j = 0; j < cfg::NUM_SENSORS; ++j) {
+            lineMeasurements[j] = std::min<uint32_t>(measurements[j] + lineMeasurements[j], 255);
+        }
+
+        const auto linePositions =
+            linePosCalculator.calculate(lineMeasurements, Line::MAX_NUM_LINES);
+        ASSERT_EQ(1, linePositions.size());
+        EXPECT_NEAR_UNIT(LINE_POS, linePositions.begin()->pos, millimeter_t(4));
+    }
+
+    // white levels near the line are kept, the rest follow the background
+    const int32_t lineIdx = std::lround(LinePosCalculator::linePosToOptoPos(LINE_POS));
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        if (std::abs(i - lineIdx) <= cfg::WHITE_LEVEL_LINE_GROUP_RADIUS) {
+            EXPECT_EQ(background[i], linePosCalculator.whiteLevels()[i]);
+        } else if (std::abs(i - lineIdx) > 4) {
+            EXPECT_NEAR(measurements[i], linePosCalculator.whiteLevels()[i], 1);
+        }
+    }
+}
+
+TEST(LinePosCalculator, scan_range) {
+    static constexpr millimeter_t LINE_POS = millimeter_t(-60);
+    static constexpr uint8_t SCAN_RANGE_RADIUS = 6;
+
+    SensorControlData sensorControl;
+    sensorControl.scanRangeCenter =
+        static_cast<uint8_t>(std::lround(LinePosCalculator::linePosToOptoPos(LINE_POS)));
+    sensorControl.scanRangeRadius = SCAN_RANGE_RADIUS;
+    const ScanRange scanRange     = sensorControl.scanRange();
+
+    LinePosCalculator linePosCalculator(false);
+    Measurements measurements;
+
+    for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+        createMeasurements({LINE_POS}, measurements);
+
+        // sensors outside the scan range are not read
+        for (uint8_t j = 0; j < cfg::NUM_SENSORS; ++j) {
+            if (j < scanRange.first || j > scanRange.second) {
+                measurements[j] = 0;
+            }
+        }
+
+        const auto linePositions =
+            linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES, scanRange);
+        ASSERT_EQ(1, linePositions.size());
+        EXPECT_NEAR_UNIT(LINE_POS, linePositions.begin()->pos, millimeter_t(4));
+        EXPECT_LE(0.7f, linePositions.begin()->probability);
+    }
+}
+
+TEST(LinePosCalculator, scan_range_too_small) {
+    LinePosCalculator linePosCalculator(false);
+    Measurements measurements;
+    createMeasurements({millimeter_t(0)}, measurements);
+
+    const uint8_t centerIdx = cfg::NUM_SENSORS / 2;
+    EXPECT_EQ(0, linePosCalculator
+                     .calculate(measurements, Line::MAX_NUM_LINES, {centerIdx - 1, centerIdx + 1})
+                     .size());
+}
+
+TEST(LinePosCalculator, stored_white_levels) {
+    LinePosCalculator linePosCalculator(true);
+    Measurements background, measurements;
+    createBackground(0, background);
+
+    // the calibration is skipped, lines are detected from the first frame
+    linePosCalculator.setWhiteLevels(background);
+    EXPECT_TRUE(linePosCalculator.isWhiteLevelCalibrated());
+
+    createMeasurements({millimeter_t(30)}, measurements);
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        measurements[i] = std::min<uint32_t>(background[i] + measurements[i], 255);
+    }
+
+    const auto linePositions = linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+    ASSERT_EQ(1, linePositions.size());
+    EXPECT_NEAR_UNIT(millimeter_t(30), linePositions.begin()->pos, millimeter_t(4));
+
+    linePosCalculator.restartWhiteLevelCalibration();
+    EXPECT_FALSE(linePosCalculator.isWhiteLevelCalibrated());
+
+    for (uint16_t i = 0; i < cfg::WHITE_LEVEL_CALIB_MIN_FRAMES; ++i) {
+        EXPECT_EQ(0, linePosCalculator.calculate(background, Line::MAX_NUM_LINES).size());
+    }
+    EXPECT_TRUE(linePosCalculator.isWhiteLevelCalibrated());
+    EXPECT_EQ(background, linePosCalculator.whiteLevels());
+}
+
+TEST(LinePosCalculator, incremental_update) {
+    static_assert(cfg::LINE_POS_CALC_MEASUREMENT_DEADBAND == 0,
+                  "Small changes are only recalculated without a deadband");
+
+    LinePosCalculator linePosCalculator(false);
+    Measurements measurements;
+    createMeasurements({millimeter_t(-40), millimeter_t(50)}, measurements);
+
+    for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+        // a few sensors change in each frame, some of them only slightly
+        for (uint8_t j = 0; j < 3; ++j) {
+            const uint8_t sensorIdx = rand() % cfg::NUM_SENSORS;
+            measurements[sensorIdx] =
+                micro::clamp<int32_t>(measurements[sensorIdx] + rand() % 61 - 30, 0, 255);
+        }
+        const uint8_t sensorIdx = rand() % cfg::NUM_SENSORS;
+        measurements[sensorIdx] =
+            micro::clamp<int32_t>(measurements[sensorIdx] + rand() % 5 - 2, 0, 255);
+
+        const ScanRange scanRange = i % 100 < 50 ? FULL_SCAN_RANGE : ScanRange{10, 40};
+
+        // a new calculator calculates the whole scan range of the same frame
+        LinePosCalculator expectedCalculator(false);
+        const auto expected =
+            expectedCalculator.calculate(measurements, Line::MAX_NUM_LINES, scanRange);
+        const auto linePositions =
+            linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES, scanRange);
+
+        ASSERT_EQ(expected.size(), linePositions.size());
+        for (auto it1 = expected.begin(), it2 = linePositions.begin(); it1 != expected.end();
+             ++it1, ++it2) {
+            EXPECT_EQ(it1->pos, it2->pos);
+            EXPECT_EQ(it1->probability, it2->probability);
+        }
+    }
+}
+
+TEST(LinePosCalculator, gaussian_estimator) {
+    LinePosCalculator centroidCalculator(false, false, linePosEstimator_t::Centroid);
+    LinePosCalculator gaussianCalculator(false, false, linePosEstimator_t::Gaussian);
+    Measurements measurements;
+
+    float centroidError = 0.0f;
+    float gaussianError = 0.0f;
+
+    for (millimeter_t linePos = millimeter_t(-100); linePos < millimeter_t(100);
+         linePos += millimeter_t(0.7f)) {
+        // noiseless Gaussian line profile
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            const float z = i - LinePosCalculator::linePosToOptoPos(linePos);
+            measurements[i] = static_cast<uint8_t>(255 * std::exp(-0.5f * z * z));
+        }
+
+        const auto centroid = centroidCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        const auto gaussian = gaussianCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        ASSERT_EQ(1, centroid.size());
+        ASSERT_EQ(1, gaussian.size());
+
+        EXPECT_NEAR_UNIT(linePos, gaussian.begin()->pos, millimeter_t(0.5f));
+        centroidError += abs(centroid.begin()->pos - linePos).get();
+        gaussianError += abs(gaussian.begin()->pos - linePos).get();
+    }
+
+    EXPECT_LT(gaussianError, centroidError / 4);
+}
+
+TEST(LinePosCalculator, frame_classification) {
+    LinePosCalculator linePosCalculator(true);
+    Measurements background, measurements;
+    createBackground(0, background);
+    linePosCalculator.setWhiteLevels(background);
+
+    createMeasurements({millimeter_t(30)}, measurements);
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        measurements[i] = std::min<uint32_t>(background[i] + measurements[i], 255);
+    }
+    EXPECT_EQ(1, linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES).size());
+    EXPECT_EQ(frameClass_t::Normal, linePosCalculator.frameClass());
+
+    // small changes of the background are not lines
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        measurements[i] = background[i] + (255 - background[i]) / 10;
+    }
+    EXPECT_EQ(0, linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES).size());
+    EXPECT_EQ(frameClass_t::NoLine, linePosCalculator.frameClass());
+
+    measurements.fill(255);
+    EXPECT_EQ(0, linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES).size());
+    EXPECT_EQ(frameClass_t::Saturated, linePosCalculator.frameClass());
+
+    measurements.fill(0);
+    EXPECT_EQ(0, linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES).size());
+    EXPECT_EQ(frameClass_t::SensorFault, linePosCalculator.frameClass());
+
+    // the sensors changed in the skipped frames are recalculated
+    createMeasurements({millimeter_t(-50)}, measurements);
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        measurements[i] = std::min<uint32_t>(background[i] + measurements[i], 255);
+    }
+    const auto linePositions = linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+    ASSERT_EQ(1, linePositions.size());
+    EXPECT_NEAR_UNIT(millimeter_t(-50), linePositions.begin()->pos, millimeter_t(4));
+    EXPECT_EQ(frameClass_t::Normal, linePosCalculator.frameClass());
+}
+
+TEST(LinePosCalculator, coarse_to_fine_search) {
+    LinePosCalculator fullCalculator(false, false, linePosEstimator_t::Centroid,
+                                     lineSearch_t::Full);
+    LinePosCalculator coarseToFineCalculator(false, false, linePosEstimator_t::Centroid,
+                                             lineSearch_t::CoarseToFine);
+    Measurements measurements;
+
+    const micro::vector<millimeter_t, Line::MAX_NUM_LINES> scenarios[] = {
+        {millimeter_t(0)},
+        {millimeter_t(-100)},
+        {millimeter_t(-10), millimeter_t(28)},
+        {millimeter_t(-80), millimeter_t(70)},
+        {millimeter_t(-120), millimeter_t(0), millimeter_t(110)}};
+
+    // the lines move between the frames, so the skipped sensors are recalculated later
+    for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+        createMeasurements(scenarios[i % std::size(scenarios)], measurements);
+
+        const auto expected = fullCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        const auto linePositions =
+            coarseToFineCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        ASSERT_EQ(expected.size(), linePositions.size());
+        for (size_t j = 0; j < expected.size(); ++j) {
+            const auto& exp  = *std::next(expected.begin(), j);
+            const auto& line = *std::next(linePositions.begin(), j);
+            EXPECT_NEAR_UNIT(exp.pos, line.pos, millimeter_t(0.01f));
+            EXPECT_NEAR(exp.probability, line.probability, 0.05f);
+            EXPECT_GE(exp.probability, line.probability);
+        }
+    }
+}
+
+TEST(LinePosCalculator, coarse_to_fine_search_fixtures) {
+    for (const lineDetector_t lineDetector :
+         {lineDetector_t::GroupIntensity, lineDetector_t::MatchedFilter}) {
+        testCoarseToFine({millimeter_t(0)}, lineDetector);
+        testCoarseToFine({millimeter_t(-100)}, lineDetector);
+        testCoarseToFine({millimeter_t(100)}, lineDetector);
+        testCoarseToFine({millimeter_t(-10), millimeter_t(28)}, lineDetector);
+        testCoarseToFine({millimeter_t(-120), millimeter_t(-90)}, lineDetector);
+        testCoarseToFine({millimeter_t(70), millimeter_t(100)}, lineDetector);
+        testCoarseToFine({millimeter_t(-80), millimeter_t(70)}, lineDetector);
+        testCoarseToFine({millimeter_t(-120), millimeter_t(0), millimeter_t(110)}, lineDetector);
+    }
+}
+
+TEST(LinePosCalculator, coarse_to_fine_search_noisy) {
+    LinePosCalculator fullCalculator(false, false, linePosEstimator_t::Centroid,
+                                     lineSearch_t::Full);
+    LinePosCalculator coarseToFineCalculator(false, false, linePosEstimator_t::Centroid,
+                                             lineSearch_t::CoarseToFine);
+    Measurements measurements;
+
+    // the coarse search never accepts a line that is rejected, or more likely, in a full search
+    for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+        const uint32_t numLines = 1 + rand() % 3;
+        micro::vector<millimeter_t, Line::MAX_NUM_LINES> lines;
+        for (uint32_t j = 0; j < numLines; ++j) {
+            lines.push_back(millimeter_t(-120 + 80 * j + rand() % 40));
+        }
+        createMeasurements(lines, measurements);
+        for (uint8_t j = 0; j < cfg::NUM_SENSORS; ++j) {
+            measurements[j] = std::min<uint32_t>(measurements[j] + rand() % 80, 255);
+        }
+
+        const auto expected = fullCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        const auto linePositions =
+            coarseToFineCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        for (const auto& line : linePositions) {
+            const auto exp = std::find_if(expected.begin(), expected.end(), [&line](const auto& e) {
+                return abs(e.pos - line.pos) < millimeter_t(0.01f);
+            });
+            ASSERT_NE(expected.end(), exp);
+            EXPECT_GE(exp->probability, line.probability);
+        }
+    }
+}
+
+TEST(LinePosCalculator, masked_sensors) {
+    static constexpr uint8_t STUCK_HIGH_IDX = 10;
+    const uint8_t stuckLowIdx =
+        std::lround(LinePosCalculator::linePosToOptoPos(millimeter_t(50))) + 1;
+
+    for (const lineDetector_t lineDetector :
+         {lineDetector_t::GroupIntensity, lineDetector_t::MatchedFilter}) {
+        LinePosCalculator unmaskedCalculator(false);
+        LinePosCalculator maskedCalculator(false);
+        unmaskedCalculator.setLineDetector(lineDetector);
+        maskedCalculator.setLineDetector(lineDetector);
+        maskedCalculator.setMaskedSensors((uint64_t(1) << STUCK_HIGH_IDX) |
+                                          (uint64_t(1) << stuckLowIdx));
+        Measurements measurements;
+
+        uint32_t numUnmaskedErrors = 0;
+        for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+            createMeasurements({millimeter_t(50)}, measurements);
+            measurements[STUCK_HIGH_IDX] = 255;
+            measurements[stuckLowIdx]    = 0;
+
+            const auto unmasked = unmaskedCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+            if (unmasked.size() != 1 ||
+                abs(unmasked.begin()->pos - millimeter_t(50)) > millimeter_t(4)) {
+                ++numUnmaskedErrors;
+            }
+
+            const auto linePositions =
+                maskedCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+            ASSERT_EQ(1, linePositions.size());
+            EXPECT_NEAR_UNIT(millimeter_t(50), linePositions.begin()->pos, millimeter_t(4));
+        }
+
+        // the stuck sensors cause fake lines, or distort the line, when they are not masked
+        EXPECT_LT(NUM_TESTS_PER_SCENARIO / 2, numUnmaskedErrors);
+    }
+}
+
+TEST(LinePosCalculator, line_edges) {
+    static constexpr millimeter_t SENSOR_PITCH = cfg::OPTO_ARRAY_LENGTH / (cfg::NUM_SENSORS - 1);
+    // full width at half maximum of the Gaussian line profile of the test measurements
+    static constexpr millimeter_t LINE_WIDTH = 2.355f * SENSOR_PITCH;
+
+    LinePosCalculator linePosCalculator(false);
+    Measurements measurements;
+
+    for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+        createMeasurements({millimeter_t(-60), millimeter_t(40)}, measurements);
+
+        const auto linePositions = linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        ASSERT_EQ(2, linePositions.size());
+        for (const auto& line : linePositions) {
+            EXPECT_LT(line.leftEdge, line.pos);
+            EXPECT_GT(line.rightEdge, line.pos);
+            EXPECT_NEAR_UNIT(LINE_WIDTH, line.width(), SENSOR_PITCH);
+        }
+    }
+
+    // the ambient light offsets the whole line profile, it does not widen the line
+    for (const uint8_t ambient : {0, 60, 100, 140}) {
+        for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+            createMeasurements({millimeter_t(-60)}, measurements);
+            for (uint8_t j = 0; j < cfg::NUM_SENSORS; ++j) {
+                measurements[j] = std::min<uint32_t>(ambient + j + measurements[j] / 2, 255);
+            }
+
+            const auto linePositions =
+                linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+            ASSERT_EQ(1, linePositions.size());
+            EXPECT_NEAR_UNIT(LINE_WIDTH, linePositions.begin()->width(), SENSOR_PITCH);
+        }
+    }
+
+    // the lines detected in a junction share the edges of the blob
+    measurements.fill(0);
+    for (uint8_t i = 20; i < 30; ++i) {
+        measurements[i] = 255;
+    }
+    const auto linePositions = linePosCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+    ASSERT_LE(1, linePositions.size());
+    for (const auto& line : linePositions) {
+        EXPECT_NEAR_UNIT(LinePosCalculator::optoIdxToLinePos(19.5f), line.leftEdge,
+                         SENSOR_PITCH / 2);
+        EXPECT_NEAR_UNIT(LinePosCalculator::optoIdxToLinePos(29.5f), line.rightEdge,
+                         SENSOR_PITCH / 2);
+        EXPECT_LT(3 * LINE_WIDTH, line.width());
+    }
+}
+
+TEST(LinePosCalculator, crosstalk_compensation) {
+    static constexpr uint8_t STRIDE  = 4; // 12 sensors lit in parallel
+    static constexpr float CROSSTALK = 0.15f;
+    static constexpr uint8_t DARK    = 255;
+    static constexpr uint8_t WHITE   = 80; // above the largest drop caused by the crosstalk
+
+    Crosstalk crosstalk;
+    crosstalk.stride = STRIDE;
+    crosstalk.dark.fill(DARK);
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        crosstalk.left[i]  = i >= STRIDE ? CROSSTALK * 65536 : 0;
+        crosstalk.right[i] = i + STRIDE < cfg::NUM_SENSORS ? CROSSTALK * 65536 : 0;
+    }
+
+    LinePosCalculator expectedCalculator(false);
+    LinePosCalculator uncompensatedCalculator(false);
+    LinePosCalculator compensatedCalculator(false);
+    compensatedCalculator.setCrosstalk(crosstalk);
+    Measurements measurements, crosstalkMeasurements;
+
+    float uncompensatedError = 0.0f;
+    float compensatedError   = 0.0f;
+
+    for (uint32_t i = 0; i < NUM_TESTS_PER_SCENARIO; ++i) {
+        createMeasurements({millimeter_t(-40), millimeter_t(50)}, measurements);
+
+        // measurements decrease with the light like on the panel, the light of a sensor is its
+        // drop below the dark level
+        for (uint8_t j = 0; j < cfg::NUM_SENSORS; ++j) {
+            measurements[j] = WHITE + measurements[j] * (DARK - WHITE) / DARK;
+        }
+
+        // the sensors lit in parallel also measure a fraction of the light of their neighbours
+        for (uint8_t j = 0; j < cfg::NUM_SENSORS; ++j) {
+            const float left  = j >= STRIDE ? DARK - measurements[j - STRIDE] : 0;
+            const float right = j + STRIDE < cfg::NUM_SENSORS ? DARK - measurements[j + STRIDE] : 0;
+            crosstalkMeasurements[j] = std::max(measurements[j] - CROSSTALK * (left + right), 0.0f);
+        }
+
+        const auto expected = expectedCalculator.calculate(measurements, Line::MAX_NUM_LINES);
+        const auto uncompensated =
+            uncompensatedCalculator.calculate(crosstalkMeasurements, Line::MAX_NUM_LINES);
+        const auto compensated =
+            compensatedCalculator.calculate(crosstalkMeasurements, Line::MAX_NUM_LINES);
+
+        ASSERT_EQ(expected.size(), uncompensated.size());
+        ASSERT_EQ(expected.size(), compensated.size());
+        for (size_t j = 0; j < expected.size(); ++j) {
+            const auto& exp = *std::next(expected.begin(), j);
+            uncompensatedError += abs(exp.pos - std::next(uncompensated.begin(), j)->pos).get();
+            compensatedError += abs(exp.pos - std::next(compensated.begin(), j)->pos).get();
+        }
+    }
+
+    // the crosstalk is removed to the first order, the light of the neighbours contains their own
+    // crosstalk as well
+    EXPECT_LT(compensatedError, uncompensatedError / 3);
+}
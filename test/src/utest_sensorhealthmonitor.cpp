@@ -0,0 +1,97 @@
+#include <SensorHealthMonitor.hpp>
+#include <cmath>
+#include <cstdlib>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr uint8_t BACKGROUND = 40;
+
+// a noisy line sweeping over the whole panel
+void createMeasurements(const uint32_t frame, Measurements& OUT meas) {
+    static constexpr float SIGMA = 1.5f;
+
+    const float linePos = (cfg::NUM_SENSORS - 1) / 2.0f * (1.0f + std::sin(frame * 0.05f));
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        const float z = (i - linePos) / SIGMA;
+        meas[i] = static_cast<uint8_t>(BACKGROUND + (200 - BACKGROUND) * std::exp(-0.5f * z * z) +
+                                       rand() % 5);
+    }
+}
+
+uint32_t runWindow(SensorHealthMonitor& monitor, uint32_t frame,
+                   void (*breakSensors)(Measurements&) = nullptr,
+                   const ScanRange& scanRange = FULL_SCAN_RANGE) {
+    Measurements measurements;
+    for (uint16_t i = 0; i < cfg::SENSOR_HEALTH_WINDOW_FRAMES; ++i, ++frame) {
+        createMeasurements(frame, measurements);
+        if (breakSensors) {
+            breakSensors(measurements);
+        }
+        monitor.update(measurements, scanRange);
+    }
+    return frame;
+}
+
+} // namespace
+
+TEST(SensorHealthMonitor, healthy) {
+    SensorHealthMonitor monitor;
+    uint32_t frame = 0;
+    for (uint8_t i = 0; i < 4; ++i) {
+        frame = runWindow(monitor, frame);
+        EXPECT_EQ(0, monitor.faultySensors());
+    }
+}
+
+TEST(SensorHealthMonitor, static_panel) {
+    SensorHealthMonitor monitor;
+    Measurements measurements;
+    measurements.fill(BACKGROUND);
+    measurements[10] = 255;
+
+    // nothing moves, so the constant sensors are not considered stuck
+    for (uint16_t i = 0; i < 2 * cfg::SENSOR_HEALTH_WINDOW_FRAMES; ++i) {
+        monitor.update(measurements, FULL_SCAN_RANGE);
+    }
+    EXPECT_EQ(0, monitor.faultySensors());
+}
+
+TEST(SensorHealthMonitor, stuck_sensors) {
+    SensorHealthMonitor monitor;
+    const auto breakSensors = [](Measurements& meas) {
+        meas[0]  = 0;
+        meas[20] = 255;
+    };
+
+    uint32_t frame = runWindow(monitor, 0, breakSensors);
+    EXPECT_EQ(sensorHealth_t::StuckLow, monitor.health(0));
+    EXPECT_EQ(sensorHealth_t::StuckHigh, monitor.health(20));
+    EXPECT_EQ((uint64_t(1) << 0) | (uint64_t(1) << 20), monitor.faultySensors());
+
+    // the sensors recover after the next window
+    frame = runWindow(monitor, frame);
+    EXPECT_EQ(sensorHealth_t::Ok, monitor.health(0));
+    EXPECT_EQ(sensorHealth_t::Ok, monitor.health(20));
+    EXPECT_EQ(0, monitor.faultySensors());
+}
+
+TEST(SensorHealthMonitor, noisy_sensor) {
+    SensorHealthMonitor monitor;
+    runWindow(monitor, 0, [](Measurements& meas) { meas[30] = rand() % 256; });
+    EXPECT_EQ(sensorHealth_t::Noisy, monitor.health(30));
+    EXPECT_EQ(uint64_t(1) << 30, monitor.faultySensors());
+}
+
+TEST(SensorHealthMonitor, scan_range) {
+    SensorHealthMonitor monitor;
+    const auto breakSensors = [](Measurements& meas) { meas[20] = 255; };
+
+    uint32_t frame = runWindow(monitor, 0, breakSensors);
+    EXPECT_EQ(uint64_t(1) << 20, monitor.faultySensors());
+
+    // sensors that are not scanned keep their health
+    runWindow(monitor, frame, nullptr, {30, 40});
+    EXPECT_EQ(uint64_t(1) << 20, monitor.faultySensors());
+}
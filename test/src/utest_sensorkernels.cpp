@@ -0,0 +1,257 @@
+#include <LinePosCalculator.hpp>
+#include <SensorKernels.hpp>
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr uint32_t NUM_TESTS = 1000;
+constexpr WeightCalculator CALC(cfg::LINE_POS_CALC_INTENSITY_GROUP_RADIUS);
+
+template <typename T>
+void expectNear(const T expected, const T actual, const float tolerance = 1e-6f) {
+    EXPECT_NEAR(IntensityTraits<T>::toFloat(expected), IntensityTraits<T>::toFloat(actual),
+                tolerance);
+}
+
+void testRemoveCrosstalk(const uint8_t stride) {
+    Measurements measurements;
+    Measurements darkLevels;
+    uint16_t leftGains[cfg::NUM_SENSORS];
+    uint16_t rightGains[cfg::NUM_SENSORS];
+    Measurements result;
+
+    // the light of a sensor is its drop below its dark level, measurements above it have no light
+    const auto light = [&measurements, &darkLevels](const uint8_t i) {
+        return std::max(darkLevels[i] - measurements[i], 0);
+    };
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            measurements[i] = rand() % 256;
+            darkLevels[i]   = rand() % 256;
+            leftGains[i]    = rand() % cfg::CROSSTALK_MAX_GAIN;
+            rightGains[i]   = rand() % cfg::CROSSTALK_MAX_GAIN;
+        }
+
+        kernel::removeCrosstalk(measurements.data(), darkLevels.data(), leftGains, rightGains,
+                                stride, result.data(), cfg::NUM_SENSORS);
+
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            float expected = measurements[i];
+            if (i >= stride) {
+                expected += leftGains[i] / 65536.0f * light(i - stride);
+            }
+            if (i + stride < cfg::NUM_SENSORS) {
+                expected += rightGains[i] / 65536.0f * light(i + stride);
+            }
+            EXPECT_NEAR(std::min(expected, 255.0f), result[i], 0.5f);
+        }
+    }
+}
+
+template <typename T>
+void testScale() {
+    Measurements measurements;
+    Measurements whiteLevels;
+    typename IntensityTraits<T>::gain_t gains[cfg::NUM_SENSORS];
+    T result[cfg::NUM_SENSORS];
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            measurements[i] = rand() % 256;
+            whiteLevels[i]  = rand() % 256;
+            gains[i]        = IntensityTraits<T>::gain(whiteLevels[i]);
+        }
+
+        kernel::scale(measurements.data(), whiteLevels.data(), gains, result, cfg::NUM_SENSORS);
+
+        // multiplying by the gain may differ from dividing by the range in the last bit
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            expectNear(IntensityTraits<T>::scale(measurements[i], whiteLevels[i]), result[i],
+                       1.0f / IntensityTraits<q15_t>::ONE);
+        }
+    }
+}
+
+template <typename T>
+void testRemoveOffset() {
+    T values[cfg::NUM_SENSORS];
+    T offsets[cfg::NUM_SENSORS];
+    T result[cfg::NUM_SENSORS];
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            values[i]  = IntensityTraits<T>::fromFloat((rand() % 1001) / 1000.0f);
+            offsets[i] = IntensityTraits<T>::fromFloat((rand() % 1001) / 1000.0f);
+        }
+
+        kernel::removeOffset(values, offsets, result, cfg::NUM_SENSORS);
+
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            expectNear(IntensityTraits<T>::removeOffset(values[i], offsets[i]), result[i]);
+        }
+    }
+}
+
+template <typename T>
+void testWeightedAverage() {
+    using traits = IntensityTraits<T>;
+
+    typename traits::accumulator_t weights[2 * CALC.radius + 1];
+    for (int8_t subIdx = -CALC.radius; subIdx <= CALC.radius; ++subIdx) {
+        weights[subIdx + CALC.radius] = traits::averageWeight(CALC.weight(subIdx), CALC.sumWeight);
+    }
+
+    T values[cfg::NUM_SENSORS];
+    T result[cfg::NUM_SENSORS];
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            values[i] = traits::fromFloat((rand() % 1001) / 1000.0f);
+        }
+
+        kernel::weightedAverage<CALC.radius>(values, weights, result, cfg::NUM_SENSORS);
+
+        for (uint8_t i = CALC.radius; i < cfg::NUM_SENSORS - CALC.radius; ++i) {
+            float expected = 0.0f;
+            for (int8_t subIdx = -CALC.radius; subIdx <= CALC.radius; ++subIdx) {
+                expected += CALC.weight(subIdx) * traits::toFloat(values[i + subIdx]);
+            }
+            EXPECT_NEAR(expected / CALC.sumWeight, traits::toFloat(result[i]), 1e-4f);
+        }
+    }
+}
+
+template <typename T>
+void testCenterOffset() {
+    static constexpr WeightCalculator LINE_POS_CALC(cfg::LINE_POS_CALC_GROUP_RADIUS);
+    using traits = IntensityTraits<T>;
+
+    typename traits::accumulator_t weights[2 * LINE_POS_CALC.radius + 1];
+    for (int8_t subIdx = -LINE_POS_CALC.radius; subIdx <= LINE_POS_CALC.radius; ++subIdx) {
+        weights[subIdx + LINE_POS_CALC.radius] = traits::weight(LINE_POS_CALC.weight(subIdx));
+    }
+
+    T window[2 * LINE_POS_CALC.radius + 1];
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        float sum  = 0.0f;
+        float sumW = 0.0f;
+        for (int8_t subIdx = -LINE_POS_CALC.radius; subIdx <= LINE_POS_CALC.radius; ++subIdx) {
+            T& value = window[subIdx + LINE_POS_CALC.radius];
+            value    = traits::fromFloat((1 + rand() % 1000) / 1000.0f);
+
+            const float mw = LINE_POS_CALC.weight(subIdx) * traits::toFloat(value);
+            sum += mw;
+            sumW += mw * subIdx;
+        }
+
+        EXPECT_NEAR(sumW / sum, kernel::centerOffset<LINE_POS_CALC.radius>(window, weights), 1e-4f);
+    }
+}
+
+// samples of a peak at the offset from the center sensor, with the given shape
+template <typename T, typename F>
+void createPeak(const float offset, const F& shape, T* const OUT window) {
+    for (int8_t subIdx = -1; subIdx <= 1; ++subIdx) {
+        window[subIdx + 1] = IntensityTraits<T>::fromFloat(shape(subIdx - offset));
+    }
+}
+
+template <typename T>
+void testParabolaOffset() {
+    T window[3];
+    float offset = 0.0f;
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        const float expected = (rand() % 1001) / 1000.0f - 0.5f;
+        createPeak(expected, [](const float x) { return 0.9f - 0.2f * x * x; }, window);
+
+        ASSERT_TRUE(kernel::parabolaOffset(window, offset));
+        EXPECT_NEAR(expected, offset, 0.01f);
+    }
+
+    // a valley is not a peak
+    createPeak(0.0f, [](const float x) { return 0.1f + 0.2f * x * x; }, window);
+    EXPECT_FALSE(kernel::parabolaOffset(window, offset));
+}
+
+template <typename T>
+void testGaussianOffset() {
+    T window[3];
+    float offset = 0.0f;
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        const float expected = (rand() % 1001) / 1000.0f - 0.5f;
+        createPeak(expected, [](const float x) { return 0.9f * std::exp(-0.5f * x * x); }, window);
+
+        ASSERT_TRUE(kernel::gaussianOffset(window, offset));
+        EXPECT_NEAR(expected, offset, 0.01f);
+    }
+
+    // the logarithm of 0 is not defined
+    createPeak(0.0f, [](const float x) { return x == 0.0f ? 0.9f : 0.0f; }, window);
+    EXPECT_FALSE(kernel::gaussianOffset(window, offset));
+
+    // neither of negative values
+    createPeak(0.0f, [](const float x) { return x == 0.0f ? 0.9f : -0.1f; }, window);
+    EXPECT_FALSE(kernel::gaussianOffset(window, offset));
+}
+
+} // namespace
+
+TEST(SensorKernels, remove_crosstalk) {
+    testRemoveCrosstalk(4);
+    testRemoveCrosstalk(8);
+}
+
+TEST(SensorKernels, scale_float) {
+    testScale<float>();
+}
+
+TEST(SensorKernels, scale_q15) {
+    testScale<q15_t>();
+}
+
+TEST(SensorKernels, remove_offset_float) {
+    testRemoveOffset<float>();
+}
+
+TEST(SensorKernels, remove_offset_q15) {
+    testRemoveOffset<q15_t>();
+}
+
+TEST(SensorKernels, weighted_average_float) {
+    testWeightedAverage<float>();
+}
+
+TEST(SensorKernels, weighted_average_q15) {
+    testWeightedAverage<q15_t>();
+}
+
+TEST(SensorKernels, center_offset_float) {
+    testCenterOffset<float>();
+}
+
+TEST(SensorKernels, center_offset_q15) {
+    testCenterOffset<q15_t>();
+}
+
+TEST(SensorKernels, parabola_offset_float) {
+    testParabolaOffset<float>();
+}
+
+TEST(SensorKernels, parabola_offset_q15) {
+    testParabolaOffset<q15_t>();
+}
+
+TEST(SensorKernels, gaussian_offset_float) {
+    testGaussianOffset<float>();
+}
+
+TEST(SensorKernels, gaussian_offset_q15) {
+    testGaussianOffset<q15_t>();
+}
@@ -0,0 +1,101 @@
+#include <SortedWindow.hpp>
+#include <cfg_sensor.hpp>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr uint32_t NUM_TESTS = 1000;
+constexpr uint8_t RADIUS     = cfg::LINE_POS_CALC_OFFSET_FILTER_RADIUS;
+constexpr uint8_t RANK       = (2 * RADIUS + 1) / 3;
+
+template <typename T>
+T referenceOrderStatistic(const T* const values, const uint8_t size, const uint8_t idx) {
+    const uint8_t startIdx = std::max<uint8_t>(idx, RADIUS) - RADIUS;
+    const uint8_t endIdx   = std::min<uint8_t>(idx + RADIUS + 1, size);
+
+    std::vector<T> group(&values[startIdx], &values[endIdx]);
+    std::sort(group.begin(), group.end());
+    return group[RANK];
+}
+
+template <typename T>
+void test(const T maxValue) {
+    T values[cfg::NUM_SENSORS];
+    T result[cfg::NUM_SENSORS];
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            values[i] = static_cast<T>(rand() % (static_cast<int32_t>(maxValue) + 1));
+        }
+
+        slidingOrderStatistic<RADIUS, RANK>(values, cfg::NUM_SENSORS, result);
+
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            ASSERT_EQ(referenceOrderStatistic(values, cfg::NUM_SENSORS, i), result[i]);
+        }
+    }
+}
+
+} // namespace
+
+TEST(SortedWindow, insert_evict) {
+    SortedWindow<int32_t, 4> window;
+    window.insert(3);
+    window.insert(1);
+    window.insert(2);
+    window.insert(1);
+
+    EXPECT_EQ(4, window.size());
+    EXPECT_EQ(1, window[0]);
+    EXPECT_EQ(1, window[1]);
+    EXPECT_EQ(2, window[2]);
+    EXPECT_EQ(3, window[3]);
+
+    window.evict(1);
+    window.evict(3);
+
+    EXPECT_EQ(2, window.size());
+    EXPECT_EQ(1, window[0]);
+    EXPECT_EQ(2, window[1]);
+}
+
+TEST(SortedWindow, order_statistic_distinct_values) {
+    test<int32_t>(1000000);
+}
+
+TEST(SortedWindow, order_statistic_duplicate_values) {
+    test<uint8_t>(3);
+}
+
+TEST(SortedWindow, order_statistic_short_array) {
+    const float values[] = {0.4f, 0.1f, 0.3f, 0.2f};
+    float result[4];
+
+    slidingOrderStatistic<RADIUS, RANK>(values, 4, result);
+
+    for (uint8_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(0.3f, result[i]);
+    }
+}
+
+TEST(SortedWindow, order_statistic_subrange) {
+    int32_t values[cfg::NUM_SENSORS];
+    int32_t result[cfg::NUM_SENSORS];
+
+    for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+        for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+            values[i] = rand() % 100;
+        }
+
+        const uint8_t begin = rand() % cfg::NUM_SENSORS;
+        const uint8_t end   = begin + 1 + rand() % (cfg::NUM_SENSORS - begin);
+        slidingOrderStatistic<RADIUS, RANK>(values, cfg::NUM_SENSORS, begin, end, result);
+
+        for (uint8_t i = begin; i < end; ++i) {
+            ASSERT_EQ(referenceOrderStatistic(values, cfg::NUM_SENSORS, i), result[i]);
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#include <WhiteLevelStorage.hpp>
+#include <array>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// RAM-backed flash, with the erase and write semantics of the NOR flash
+template <uint32_t SIZE>
+class FlashMock : public Flash {
+  public:
+    FlashMock() { this->data_.fill(0xff); }
+
+    uint32_t size() const override { return SIZE; }
+
+    void read(const uint32_t offset, void* const OUT data, const uint32_t size) const override {
+        std::memcpy(data, &this->data_[offset], size);
+    }
+
+    bool write(const uint32_t offset, const void* const data, const uint32_t size) override {
+        if (offset + size > SIZE) {
+            return false;
+        }
+
+        const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+        for (uint32_t i = 0; i < size; ++i) {
+            this->data_[offset + i] &= bytes[i];
+        }
+        return true;
+    }
+
+    bool erase() override {
+        this->data_.fill(0xff);
+        this->numErases++;
+        return true;
+    }
+
+    void flipBit(const uint32_t offset, const uint8_t bit) { this->data_[offset] ^= 1 << bit; }
+
+    uint32_t numErases = 0;
+
+  private:
+    std::array<uint8_t, SIZE> data_;
+};
+
+Measurements createWhiteLevels(const uint8_t base) {
+    Measurements whiteLevels;
+    for (uint8_t i = 0; i < cfg::NUM_SENSORS; ++i) {
+        whiteLevels[i] = base + i;
+    }
+    return whiteLevels;
+}
+
+} // namespace
+
+TEST(WhiteLevelStorage, empty) {
+    FlashMock<256> flash;
+    WhiteLevelStorage storage(flash);
+
+    Measurements whiteLevels;
+    EXPECT_FALSE(storage.load(whiteLevels));
+}
+
+TEST(WhiteLevelStorage, store_load) {
+    FlashMock<256> flash;
+    WhiteLevelStorage storage(flash);
+
+    const Measurements expected = createWhiteLevels(10);
+    ASSERT_TRUE(storage.store(expected));
+
+    Measurements whiteLevels;
+    ASSERT_TRUE(WhiteLevelStorage(flash).load(whiteLevels));
+    EXPECT_EQ(expected, whiteLevels);
+}
+
+TEST(WhiteLevelStorage, last_record_loaded) {
+    FlashMock<256> flash;
+    WhiteLevelStorage storage(flash);
+
+    for (uint8_t i = 0; i < 10; ++i) {
+        ASSERT_TRUE(storage.compact());
+        ASSERT_TRUE(storage.store(createWhiteLevels(i)));
+
+        Measurements whiteLevels;
+        ASSERT_TRUE(storage.load(whiteLevels));
+        EXPECT_EQ(createWhiteLevels(i), whiteLevels);
+    }
+
+    // the flash is only erased when more than half of the record slots have been used
+    EXPECT_GT(10u, flash.numErases);
+    EXPECT_LT(0u, flash.numErases);
+}
+
+TEST(WhiteLevelStorage, full) {
+    FlashMock<256> flash; // 4 record slots
+    WhiteLevelStorage storage(flash);
+
+    for (uint8_t i = 0; i < 4; ++i) {
+        ASSERT_TRUE(storage.store(createWhiteLevels(i)));
+    }
+
+    // a full flash is not erased when storing, the records are kept until the next compaction
+    EXPECT_FALSE(storage.store(createWhiteLevels(10)));
+    EXPECT_EQ(0u, flash.numErases);
+
+    Measurements whiteLevels;
+    ASSERT_TRUE(storage.load(whiteLevels));
+    EXPECT_EQ(createWhiteLevels(3), whiteLevels);
+
+    ASSERT_TRUE(storage.compact());
+    EXPECT_EQ(1u, flash.numErases);
+    ASSERT_TRUE(storage.load(whiteLevels));
+    EXPECT_EQ(createWhiteLevels(3), whiteLevels);
+
+    ASSERT_TRUE(storage.store(createWhiteLevels(10)));
+    ASSERT_TRUE(storage.load(whiteLevels));
+    EXPECT_EQ(createWhiteLevels(10), whiteLevels);
+}
+
+TEST(WhiteLevelStorage, compact) {
+    FlashMock<256> flash; // 4 record slots
+    WhiteLevelStorage storage(flash);
+
+    // an empty flash is not erased
+    ASSERT_TRUE(storage.compact());
+    EXPECT_EQ(0u, flash.numErases);
+
+    // a half used flash is not erased
+    ASSERT_TRUE(storage.store(createWhiteLevels(10)));
+    ASSERT_TRUE(storage.store(createWhiteLevels(20)));
+    ASSERT_TRUE(storage.compact());
+    EXPECT_EQ(0u, flash.numErases);
+
+    // only the last record is kept
+    ASSERT_TRUE(storage.store(createWhiteLevels(30)));
+    ASSERT_TRUE(storage.compact());
+    EXPECT_EQ(1u, flash.numErases);
+
+    Measurements whiteLevels;
+    ASSERT_TRUE(storage.load(whiteLevels));
+    EXPECT_EQ(createWhiteLevels(30), whiteLevels);
+
+    ASSERT_TRUE(storage.compact());
+    EXPECT_EQ(1u, flash.numErases);
+}
+
+TEST(WhiteLevelStorage, corrupted_record) {
+    FlashMock<256> flash;
+    WhiteLevelStorage storage(flash);
+
+    ASSERT_TRUE(storage.store(createWhiteLevels(10)));
+    ASSERT_TRUE(storage.store(createWhiteLevels(20)));
+
+    // corrupts the first white level of the second record, the first record is used instead
+    static constexpr uint32_t RECORD_SIZE = 12 + cfg::NUM_SENSORS; // header, levels, checksum
+    flash.flipBit(RECORD_SIZE + 8, 0);
+
+    Measurements whiteLevels;
+    ASSERT_TRUE(storage.load(whiteLevels));
+    EXPECT_EQ(createWhiteLevels(10), whiteLevels);
+}